@@ -0,0 +1,712 @@
+#include <josk/arena.hpp>
+#include <josk/conditions.hpp>
+#include <josk/config.hpp>
+#include <josk/formid_table.hpp>
+#include <josk/io.hpp>
+#include <josk/json.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <synthetic_plugin.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if JOSK_IO_URING
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+/** Reports records per second alongside the bytes per second computed by the benchmark library. */
+void set_throughput(benchmark::State& state, const std::uint64_t bytes, const std::uint64_t records)
+{
+	state.SetBytesProcessed(static_cast<std::int64_t>(bytes) * state.iterations());
+	state.counters["records_per_second"] = benchmark::Counter(
+			static_cast<double>(records) * static_cast<double>(state.iterations()), benchmark::Counter::kIsRate
+	);
+}
+
+void to_record_type(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		for (const auto record_type_string : josk::tes::record_type_str)
+		{
+			benchmark::DoNotOptimize(josk::tes::to_record_type(record_type_string));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(josk::tes::record_type_str.size()));
+}
+
+void record_fingerprint(benchmark::State& state)
+{
+	const auto size = static_cast<std::size_t>(state.range(0));
+	std::vector<char> data(size);
+	std::mt19937 generator{};
+	for (auto& value : data)
+	{
+		value = static_cast<char>(generator());
+	}
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(josk::tes::record_fingerprint(0U, data));
+	}
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Escapes a string of the size of a long description as JSON.
+ * @param state Benchmark state.
+ * @param characters Characters used to generate the string.
+ */
+void append_json_string(benchmark::State& state, const std::string_view characters)
+{
+	std::string value(static_cast<std::size_t>(state.range(0)), ' ');
+	std::mt19937 generator{};
+	for (auto& character : value)
+	{
+		character = characters[generator() % characters.size()];
+	}
+	std::string output;
+	for (auto _ : state)
+	{
+		output.clear();
+		josk::json::append_string(output, value);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/** Plain ASCII text, which is copied without checking each character on its own. */
+void append_ascii_json_string(benchmark::State& state)
+{
+	append_json_string(state, "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789.,;:'-+%()");
+}
+
+/** Text with some Windows-1252 characters, which are transcoded into UTF-8. */
+void append_windows_1252_json_string(benchmark::State& state)
+{
+	append_json_string(state, "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789.,\"\xE9\xF1\x93\x94");
+}
+
+/** Formids of a plugin, with the layout of the formids of a real plugin: sequential inside of a master index. */
+std::vector<josk::tes::formid_t> make_formids(const std::size_t count)
+{
+	std::vector<josk::tes::formid_t> formids(count);
+	for (std::size_t index{}; index < count; ++index)
+	{
+		formids[index] = 0x01000800U + static_cast<josk::tes::formid_t>(index);
+	}
+	return formids;
+}
+
+void formid_set_insert(benchmark::State& state)
+{
+	const auto formids = make_formids(static_cast<std::size_t>(state.range(0)));
+	for (auto _ : state)
+	{
+		std::unordered_set<josk::tes::formid_t> formid_set;
+		for (const auto formid : formids)
+		{
+			formid_set.emplace(formid);
+		}
+		benchmark::DoNotOptimize(formid_set);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void formid_set_contains(benchmark::State& state)
+{
+	const auto formids = make_formids(static_cast<std::size_t>(state.range(0)));
+	const std::unordered_set<josk::tes::formid_t> formid_set(formids.cbegin(), formids.cend());
+	for (auto _ : state)
+	{
+		for (const auto formid : formids)
+		{
+			benchmark::DoNotOptimize(formid_set.contains(formid));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void formid_winner_table_claim(benchmark::State& state)
+{
+	const auto formids = make_formids(static_cast<std::size_t>(state.range(0)));
+	for (auto _ : state)
+	{
+		josk::tes::formid_winner_table winners{formids.size()};
+		for (const auto formid : formids)
+		{
+			benchmark::DoNotOptimize(winners.claim(formid, 1));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/** Table shared by all threads of formid_winner_table_contended_claim. */
+std::unique_ptr<josk::tes::formid_winner_table> contended_winners;
+
+/**
+ * Each thread claims the same formids with its own priority, like plugins overriding the same records. Odd threads
+ * claim them in reverse order, so claims with different priorities arrive in every order. The benchmark fails if any
+ * formid is not won by the highest priority.
+ */
+void formid_winner_table_contended_claim(benchmark::State& state)
+{
+	const auto formids = make_formids(static_cast<std::size_t>(state.range(0)));
+	if (state.thread_index() == 0)
+	{
+		contended_winners = std::make_unique<josk::tes::formid_winner_table>(formids.size());
+	}
+	const josk::tes::priority_t priority{state.thread_index()};
+	const bool reverse = state.thread_index() % 2 != 0;
+	for (auto _ : state)
+	{
+		for (std::size_t index{}; index < formids.size(); ++index)
+		{
+			const auto formid = formids[reverse ? formids.size() - index - 1Z : index];
+			benchmark::DoNotOptimize(contended_winners->claim(formid, priority));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+
+	if (state.thread_index() != 0)
+	{
+		return;
+	}
+	const josk::tes::priority_t highest_priority{state.threads() - 1};
+	const auto lost = std::ranges::find_if(
+			formids, [highest_priority](const josk::tes::formid_t formid)
+			{ return contended_winners->winner(formid) != highest_priority; }
+	);
+	if (lost != formids.end())
+	{
+		state.SkipWithError(std::format("Formid {:08X} is not won by priority {}.", *lost, highest_priority));
+	}
+	contended_winners.reset();
+}
+
+/**
+ * Parses a whole plugin from memory. The plugin only contains a group of the record type being measured.
+ * @param state Benchmark state.
+ * @param spec Plugin contents.
+ * @param records Records of the type being measured.
+ */
+void parse_synthetic_plugin(
+		benchmark::State& state, const josk::synthetic::plugin_spec_t& spec, const std::uint64_t records
+)
+{
+	const auto data = josk::synthetic::write_plugin(spec);
+	const josk::tes::parse_options_t options{};
+	josk::memory::arena_t arena{};
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		josk::io::buffer_t buffer{data};
+		josk::tes::parsed_records_t parsed_records{};
+		josk::tes::formid_winner_table winners{1024Z};
+		state.ResumeTiming();
+
+		josk::tes::plugin_data_t plugin_data{.buffer = std::move(buffer), .segments = {}};
+		const auto result = josk::tes::open_plugin(
+																"synthetic.esp", "synthetic.esp", 1, std::move(plugin_data), parsed_records, winners,
+																arena.resource(), options, nullptr
+		)
+																.and_then(josk::tes::parse_plugin)
+																.and_then(josk::tes::close_plugin);
+		arena.reset();
+		if (!result.has_value())
+		{
+			state.SkipWithError(result.error());
+			break;
+		}
+		benchmark::DoNotOptimize(parsed_records);
+	}
+	set_throughput(state, data.size(), records);
+}
+
+void parse_avif_group(benchmark::State& state)
+{
+	const josk::synthetic::plugin_spec_t spec{
+			.avif_count = static_cast<std::uint32_t>(state.range(0)),
+			.perks_per_avif = 20U,
+			.ignored_group_count = 0U,
+			.ignored_records_per_group = 0U,
+	};
+	// Perks are placed in their own group, and they are parsed as well.
+	parse_synthetic_plugin(state, spec, josk::synthetic::record_count(spec));
+}
+
+void parse_perk_group(benchmark::State& state)
+{
+	const josk::synthetic::plugin_spec_t spec{
+			.avif_count = 1U,
+			.perks_per_avif = static_cast<std::uint32_t>(state.range(0)),
+			.ignored_group_count = 0U,
+			.ignored_records_per_group = 0U,
+	};
+	parse_synthetic_plugin(state, spec, josk::synthetic::record_count(spec));
+}
+
+void skip_ignored_groups(benchmark::State& state)
+{
+	const josk::synthetic::plugin_spec_t spec{
+			.avif_count = 0U,
+			.perks_per_avif = 0U,
+			.ignored_group_count = static_cast<std::uint32_t>(state.range(0)),
+			.ignored_records_per_group = 4096U,
+	};
+	parse_synthetic_plugin(state, spec, josk::synthetic::record_count(spec));
+}
+
+/** Field validation and decoding of a single PERK record, without any group traversal. */
+void decode_perk_record(benchmark::State& state)
+{
+	const josk::synthetic::plugin_spec_t spec{
+			.avif_count = 1U,
+			.perks_per_avif = 2U,
+			.ignored_group_count = 0U,
+			.ignored_records_per_group = 0U,
+	};
+	const auto data = josk::synthetic::write_plugin(spec);
+
+	// Index the plugin to find the location of the record data.
+	constexpr josk::tes::parse_options_t index_options{.mode = josk::tes::parse_mode_t::index};
+	josk::memory::arena_t arena{};
+	josk::tes::parsed_records_t index{};
+	josk::tes::formid_winner_table winners{1024Z};
+	josk::tes::plugin_data_t plugin_data{.buffer = josk::io::buffer_t{data}, .segments = {}};
+	const auto index_result =
+			josk::tes::open_plugin(
+					"synthetic.esp", "synthetic.esp", 1, std::move(plugin_data), index, winners, arena.resource(), index_options,
+					nullptr
+			)
+					.and_then(josk::tes::parse_plugin)
+					.and_then(josk::tes::close_plugin);
+	arena.reset();
+	if (!index_result.has_value() || index.record_handles.size() < 2Z)
+	{
+		state.SkipWithError("Could not index the synthetic plugin.");
+		return;
+	}
+	const auto handle = index.record_handles.back();
+	const auto record_begin = data.cbegin() + static_cast<std::ptrdiff_t>(handle.offset);
+	const josk::io::buffer_t record_data(record_begin, record_begin + handle.size);
+
+	for (auto _ : state)
+	{
+		josk::tes::parsed_records_t parsed_records{};
+		auto decode_result =
+				josk::tes::decode_record(handle, "synthetic.esp", record_data, parsed_records, arena.resource());
+		arena.reset();
+		benchmark::DoNotOptimize(decode_result);
+	}
+	set_throughput(state, record_data.size(), 1U);
+}
+
+/** Evaluates the requirements of a perk for a batch of random character builds. */
+void evaluate_conditions(benchmark::State& state)
+{
+	using josk::tes::condition_function_t;
+
+	const auto build_count = static_cast<std::size_t>(state.range(0));
+	constexpr std::array<josk::tes::formid_t, 4Z> perk_ids{0x00058F61U, 0x00058F62U, 0x00058F63U, 0x00058F64U};
+	std::mt19937 generator{};
+	std::uniform_real_distribution<float> skill_distribution{15.0F, 100.0F};
+	std::uniform_int_distribution<int> perk_distribution{0, 1};
+	std::vector<float> actor_values(josk::conditions::actor_value_count * build_count);
+	for (auto& actor_value : actor_values)
+	{
+		actor_value = skill_distribution(generator);
+	}
+	std::vector<float> levels(build_count);
+	for (auto& level : levels)
+	{
+		level = skill_distribution(generator) / 2.0F;
+	}
+	std::vector<std::uint8_t> perks(perk_ids.size() * build_count);
+	for (auto& perk : perks)
+	{
+		perk = static_cast<std::uint8_t>(perk_distribution(generator));
+	}
+	const josk::conditions::build_batch_t batch{
+			.size = build_count, .actor_values = actor_values, .levels = levels, .perk_ids = perk_ids, .perks = perks
+	};
+
+	// Requires a skill level, either the previous rank or a character level, and another perk.
+	josk::tes::condition_program_t program;
+	const auto add_condition = [&program](
+																 const condition_function_t function, const josk::tes::compare_op_t op,
+																 const std::uint32_t param1, const float value, const std::uint8_t flags
+														 )
+	{
+		auto& condition = program.conditions.emplace_back();
+		condition.function = function;
+		condition.op = op;
+		condition.param1 = param1;
+		condition.value = value;
+		condition.flags = flags;
+	};
+	add_condition(condition_function_t::get_base_actor_value, josk::tes::compare_op_t::greater_equal, 10U, 50.0F, 0U);
+	add_condition(
+			condition_function_t::has_perk, josk::tes::compare_op_t::equal, perk_ids[1Z], 1.0F, josk::tes::condition_or_flag
+	);
+	add_condition(condition_function_t::get_level, josk::tes::compare_op_t::greater_equal, 0U, 30.0F, 0U);
+	add_condition(condition_function_t::has_perk, josk::tes::compare_op_t::equal, perk_ids[3Z], 1.0F, 0U);
+
+	std::vector<std::uint8_t> results(build_count);
+	for (auto _ : state)
+	{
+		josk::conditions::evaluate(program, batch, results);
+		benchmark::DoNotOptimize(results.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/** Modlist generated once and shared by all end-to-end benchmarks. Removed when the process exits. */
+class synthetic_modlist final
+{
+	fs::path _root;
+	josk::synthetic::modlist_spec_t _spec{};
+	josk::synthetic::modlist_paths_t _paths;
+	std::uint64_t _bytes{};
+
+public:
+	synthetic_modlist()
+		: _root{fs::temp_directory_path() / std::format("josk_bench_{}", std::random_device{}())}
+	{
+		auto paths = josk::synthetic::write_modlist(_root, _spec);
+		if (!paths.has_value())
+		{
+			throw std::runtime_error(paths.error());
+		}
+		_paths = std::move(paths.value());
+		for (const auto& entry : fs::recursive_directory_iterator{_root})
+		{
+			if (entry.is_regular_file() && entry.path().extension() != ".txt")
+			{
+				_bytes += entry.file_size();
+			}
+		}
+	}
+
+	synthetic_modlist(const synthetic_modlist&) = delete;
+	synthetic_modlist(synthetic_modlist&&) = delete;
+	synthetic_modlist& operator=(const synthetic_modlist&) = delete;
+	synthetic_modlist& operator=(synthetic_modlist&&) = delete;
+
+	~synthetic_modlist()
+	{
+		std::error_code error{};
+		fs::remove_all(_root, error);
+	}
+
+	[[nodiscard]] josk::cli::arguments_t arguments() const
+	{
+		josk::cli::arguments_t arguments{};
+		arguments.profile_path = _paths.profile_path;
+		arguments.data_path = _paths.data_path;
+		arguments.mods_path = _paths.mods_path;
+		arguments.output_path = _root;
+		return arguments;
+	}
+
+	/** Total size of all plugins. */
+	[[nodiscard]] std::uint64_t bytes() const noexcept
+	{
+		return _bytes;
+	}
+
+	/** Total number of records of all plugins. */
+	[[nodiscard]] std::uint64_t records() const noexcept
+	{
+		return (std::uint64_t{_spec.mod_count} + 1U) * josk::synthetic::record_count(_spec.plugin);
+	}
+};
+
+const synthetic_modlist& modlist()
+{
+	static const synthetic_modlist instance{};
+	return instance;
+}
+
+void find_plugins(benchmark::State& state)
+{
+	const auto& synthetic = modlist();
+	for (auto _ : state)
+	{
+		auto result = josk::task::parse_load_order(synthetic.arguments()).and_then(josk::task::find_plugins);
+		if (!result.has_value())
+		{
+			state.SkipWithError(result.error());
+			break;
+		}
+		benchmark::DoNotOptimize(result);
+	}
+}
+
+void parse_plugins(benchmark::State& state)
+{
+	const auto& synthetic = modlist();
+	const auto plugins = josk::task::parse_load_order(synthetic.arguments()).and_then(josk::task::find_plugins);
+	if (!plugins.has_value())
+	{
+		state.SkipWithError(plugins.error());
+		return;
+	}
+	for (auto _ : state)
+	{
+		auto result = josk::task::parse_plugins(plugins.value(), josk::tes::default_record_types);
+		if (!result.has_value())
+		{
+			state.SkipWithError(result.error());
+			break;
+		}
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, synthetic.bytes(), synthetic.records());
+}
+
+void index_plugins(benchmark::State& state)
+{
+	const auto& synthetic = modlist();
+	const auto plugins = josk::task::parse_load_order(synthetic.arguments()).and_then(josk::task::find_plugins);
+	if (!plugins.has_value())
+	{
+		state.SkipWithError(plugins.error());
+		return;
+	}
+	for (auto _ : state)
+	{
+		auto result = josk::task::index_plugins(plugins.value(), josk::tes::default_record_types);
+		if (!result.has_value())
+		{
+			state.SkipWithError(result.error());
+			break;
+		}
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, synthetic.bytes(), synthetic.records());
+}
+
+/** Decodes the final version of a whole load order, after indexing it. */
+void materialize_plugins(benchmark::State& state)
+{
+	const auto& synthetic = modlist();
+	const auto plugins = josk::task::parse_load_order(synthetic.arguments()).and_then(josk::task::find_plugins);
+	if (!plugins.has_value())
+	{
+		state.SkipWithError(plugins.error());
+		return;
+	}
+	for (auto _ : state)
+	{
+		auto result = josk::task::materialize_plugins(plugins.value(), josk::tes::default_record_types);
+		if (!result.has_value())
+		{
+			state.SkipWithError(result.error());
+			break;
+		}
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, synthetic.bytes(), synthetic.records());
+}
+
+/** Decodes a single skill tree from an index, reading only the records it contains. */
+void materialize_perk_tree(benchmark::State& state)
+{
+	const auto& synthetic = modlist();
+	const auto index =
+			josk::task::parse_load_order(synthetic.arguments())
+					.and_then(josk::task::find_plugins)
+					.and_then([](std::vector<josk::task::plugin_t> plugins)
+										{ return josk::task::index_plugins(std::move(plugins), josk::tes::default_record_types); });
+	if (!index.has_value())
+	{
+		state.SkipWithError(index.error());
+		return;
+	}
+	const auto avif_ids = index->record_ids(josk::tes::record_type_t::avif);
+	if (avif_ids.empty())
+	{
+		state.SkipWithError("The synthetic modlist has no skill trees.");
+		return;
+	}
+	for (auto _ : state)
+	{
+		auto result = josk::task::materialize_perk_tree(index.value(), avif_ids.front());
+		if (!result.has_value())
+		{
+			state.SkipWithError(result.error());
+			break;
+		}
+		benchmark::DoNotOptimize(result);
+	}
+}
+
+/** Reads the first perks of a plugin file, stopping without reading the rest of the file. */
+void read_first_perks(benchmark::State& state)
+{
+	const auto path = modlist().arguments().data_path / "Skyrim.esm";
+	const auto perk_count = static_cast<std::size_t>(state.range(0));
+	for (auto _ : state)
+	{
+		auto reader = josk::tes::record_reader::open(path, josk::tes::to_record_type_set(josk::tes::record_type_t::perk));
+		if (!reader.has_value())
+		{
+			state.SkipWithError(reader.error());
+			break;
+		}
+		std::size_t read_perks{};
+		for (const auto& record : reader.value())
+		{
+			benchmark::DoNotOptimize(record.data.data());
+			if (++read_perks == perk_count)
+			{
+				break;
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#if JOSK_IO_URING
+/** Removes a file from the page cache, so the next read of the file comes from disk. */
+bool evict_from_page_cache(const fs::path& path)
+{
+	const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+	// Dirty pages are not evicted, and plugins are written just before the benchmarks run.
+	const bool evicted = ::fdatasync(descriptor) == 0 && ::posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	::close(descriptor);
+	return evicted;
+}
+
+/** Reads every plugin of the modlist from a cold page cache, with the backend given as argument. */
+void read_plugins_cold(benchmark::State& state)
+{
+	const auto& synthetic = modlist();
+	const auto plugins = josk::task::parse_load_order(synthetic.arguments()).and_then(josk::task::find_plugins);
+	if (!plugins.has_value())
+	{
+		state.SkipWithError(plugins.error());
+		return;
+	}
+	const auto backend = static_cast<josk::io::backend_t>(state.range(0));
+	if (backend == josk::io::backend_t::io_uring && josk::io::available_backend() != backend)
+	{
+		state.SkipWithError("io_uring is not available in this system.");
+		return;
+	}
+	std::vector<josk::io::read_request_t> requests;
+	for (const auto& plugin : plugins.value())
+	{
+		requests.emplace_back(josk::io::read_request_t{.path = plugin.path});
+	}
+
+	std::uint64_t bytes{};
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		const auto not_evicted = std::ranges::find_if_not(
+				requests, [](const josk::io::read_request_t& request) { return evict_from_page_cache(request.path); }
+		);
+		state.ResumeTiming();
+		if (not_evicted != requests.end())
+		{
+			state.SkipWithError(std::format("Could not evict {} from the page cache.", not_evicted->path.string()));
+			break;
+		}
+		auto results = josk::io::read(requests, backend);
+		for (const auto& result : results)
+		{
+			if (!result.has_value())
+			{
+				state.SkipWithError(result.error());
+				break;
+			}
+			bytes += result->size();
+		}
+		benchmark::DoNotOptimize(results);
+	}
+	state.SetLabel(std::string{josk::io::to_backend_string(backend)});
+	state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+}
+#endif
+
+/** End-to-end benchmarks depend on disk and scheduling. Repetitions make their results comparable between runs. */
+constexpr int end_to_end_repetitions = 5;
+
+}
+
+BENCHMARK(to_record_type);
+BENCHMARK(record_fingerprint)->Arg(64)->Arg(4096);
+BENCHMARK(append_ascii_json_string)->Arg(32)->Arg(1024);
+BENCHMARK(append_windows_1252_json_string)->Arg(32)->Arg(1024);
+BENCHMARK(formid_set_insert)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(formid_set_contains)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(formid_winner_table_claim)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(formid_winner_table_contended_claim)->Arg(1 << 16)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(parse_avif_group)->Arg(18)->Arg(180);
+BENCHMARK(parse_perk_group)->Arg(100)->Arg(10000);
+BENCHMARK(skip_ignored_groups)->Arg(8)->Arg(64);
+BENCHMARK(decode_perk_record);
+BENCHMARK(evaluate_conditions)->Arg(1 << 10)->Arg(10000);
+BENCHMARK(read_first_perks)->Arg(1)->Arg(360);
+BENCHMARK(find_plugins)
+		->Unit(benchmark::kMillisecond)
+		->Repetitions(end_to_end_repetitions)
+		->ReportAggregatesOnly(true)
+		->UseRealTime();
+BENCHMARK(parse_plugins)
+		->Unit(benchmark::kMillisecond)
+		->Repetitions(end_to_end_repetitions)
+		->ReportAggregatesOnly(true)
+		->UseRealTime();
+BENCHMARK(index_plugins)
+		->Unit(benchmark::kMillisecond)
+		->Repetitions(end_to_end_repetitions)
+		->ReportAggregatesOnly(true)
+		->UseRealTime();
+BENCHMARK(materialize_plugins)
+		->Unit(benchmark::kMillisecond)
+		->Repetitions(end_to_end_repetitions)
+		->ReportAggregatesOnly(true)
+		->UseRealTime();
+BENCHMARK(materialize_perk_tree)->Unit(benchmark::kMillisecond)->UseRealTime();
+#if JOSK_IO_URING
+BENCHMARK(read_plugins_cold)
+		->Arg(static_cast<std::int64_t>(josk::io::backend_t::portable))
+		->Arg(static_cast<std::int64_t>(josk::io::backend_t::io_uring))
+		->Unit(benchmark::kMillisecond)
+		->Repetitions(end_to_end_repetitions)
+		->ReportAggregatesOnly(true)
+		->UseRealTime();
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,7 @@
+include_guard(GLOBAL)
+
+option(JOSK_BENCHMARKS "Build the josk_bench benchmark suite" OFF)
+
+if (JOSK_BENCHMARKS)
+	find_package(benchmark CONFIG REQUIRED)
+endif ()
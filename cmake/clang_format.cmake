@@ -16,7 +16,7 @@ if (JOSK_CLANG_FORMAT_BINARY)
 		list(APPEND JOSK_CLANG_FORMAT_OPTIONS -Werror)
 	endif ()
 
-	file(GLOB_RECURSE JOSK_CLANG_FORMAT_FILES ${PROJECT_SOURCE_DIR}/src/*.cpp ${PROJECT_SOURCE_DIR}/src/*.hpp ${PROJECT_SOURCE_DIR}/tests/*.cpp ${PROJECT_SOURCE_DIR}/tests/*.hpp)
+	file(GLOB_RECURSE JOSK_CLANG_FORMAT_FILES ${PROJECT_SOURCE_DIR}/src/*.cpp ${PROJECT_SOURCE_DIR}/src/*.hpp ${PROJECT_SOURCE_DIR}/bench/*.cpp ${PROJECT_SOURCE_DIR}/bench/*.hpp ${PROJECT_SOURCE_DIR}/tools/*.cpp ${PROJECT_SOURCE_DIR}/tools/*.hpp ${PROJECT_SOURCE_DIR}/tests/*.cpp ${PROJECT_SOURCE_DIR}/tests/*.hpp)
 	list(APPEND JOSK_CLANG_FORMAT_OPTIONS ${JOSK_CLANG_FORMAT_FILES})
 
 	set(JOSK_CLANG_FORMAT_TIMESTAMP_FILE ${CMAKE_CURRENT_BINARY_DIR}/clang_format_timestamp.txt)
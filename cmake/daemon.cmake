@@ -0,0 +1,7 @@
+include_guard(GLOBAL)
+
+option(JOSK_DAEMON "Build the daemon subcommand, which watches a modlist with inotify on Linux" OFF)
+
+if (JOSK_DAEMON AND NOT CMAKE_SYSTEM_NAME STREQUAL "Linux")
+	message(FATAL_ERROR "JOSK_DAEMON is only supported on Linux.")
+endif ()
@@ -0,0 +1,12 @@
+include_guard(GLOBAL)
+
+option(JOSK_IO_URING "Read plugin files with io_uring on Linux" OFF)
+
+if (JOSK_IO_URING)
+	if (NOT CMAKE_SYSTEM_NAME STREQUAL "Linux")
+		message(FATAL_ERROR "JOSK_IO_URING is only supported on Linux.")
+	endif ()
+
+	find_package(PkgConfig REQUIRED)
+	pkg_check_modules(liburing REQUIRED IMPORTED_TARGET liburing)
+endif ()
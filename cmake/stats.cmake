@@ -0,0 +1,9 @@
+include_guard(GLOBAL)
+
+option(JOSK_STATS "Collect performance statistics and traces, shown with the --stats and --trace command line options" ON)
+
+option(JOSK_MEMORY_STATS "Count global allocations of each task, shown in the --stats report. Requires JOSK_STATS" OFF)
+
+if (JOSK_MEMORY_STATS AND NOT JOSK_STATS)
+	message(FATAL_ERROR "JOSK_MEMORY_STATS requires JOSK_STATS.")
+endif ()
@@ -0,0 +1,3 @@
+include_guard(GLOBAL)
+
+option(JOSK_TOOLS "Build josk_generate and other development tools" OFF)
@@ -0,0 +1,39 @@
+#include <josk/arena.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace josk::memory
+{
+
+counting_resource::counting_resource(std::pmr::memory_resource* upstream) noexcept
+	: _upstream{upstream}
+{
+}
+
+void* counting_resource::do_allocate(const std::size_t bytes, const std::size_t alignment)
+{
+	++_allocations;
+	_allocated_bytes += bytes;
+	return _upstream->allocate(bytes, alignment);
+}
+
+void counting_resource::do_deallocate(void* pointer, const std::size_t bytes, const std::size_t alignment)
+{
+	_upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool counting_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+arena_t::arena_t(const std::size_t initial_size)
+	: _initial_buffer{std::make_unique_for_overwrite<std::byte[]>(initial_size)}
+	, _upstream{std::pmr::new_delete_resource()}
+	, _resource{_initial_buffer.get(), initial_size, &_upstream}
+{
+}
+
+}
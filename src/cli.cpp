@@ -1,11 +1,22 @@
 #include <josk/cli.hpp>
+#include <josk/daemon.hpp>
+#include <josk/stats.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
 
 #include <CLI/App.hpp>
+#include <CLI/Error.hpp>
+#include <CLI/Validators.hpp>
 
+#include <cstdint>
 #include <expected>
 #include <filesystem>
 #include <format>
+#include <map>
+#include <span>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 namespace josk::cli
 {
@@ -15,22 +26,141 @@ void configure_cli(CLI::App& app, arguments_t& arguments)
 	app.name("josk");
 	app.description("Generate JSON data from a Skyrim modlist.");
 
-	app.add_option("-p,--profile", arguments.profile_path, "Path to Mod Organizer 2 profile..")->required(true);
+	app.add_option_function<std::vector<std::filesystem::path>>(
+		"-p,--profile",
+		[&arguments](const std::vector<std::filesystem::path>& profile_paths)
+		{
+			arguments.profile_path = profile_paths.front();
+			if (profile_paths.size() > 1Z)
+			{
+				arguments.batch_profile_paths = profile_paths;
+			}
+		},
+		"Path to Mod Organizer 2 profile. Repeat it to extract several profiles sharing the Data and mods folders."
+	)
+		->required(true);
 	app.add_option("-d,--data", arguments.data_path, "Path to Data folder.")->required(true);
 	app.add_option("-m,--mods", arguments.mods_path, "Path to mods folder.")->required(true);
-	app.add_option("-o,--output", arguments.output_path, "Path to output folder.")->required(true);
+	// The daemon subcommand does not write any output.
+	app.add_option("-o,--output", arguments.output_path, "Path to output folder.");
+	app.add_option_function<std::vector<std::string>>(
+		"-t,--types",
+		[&arguments](const std::vector<std::string>& record_type_names)
+		{
+			arguments.record_types.reset();
+			for (const auto& record_type_name : record_type_names)
+			{
+				const auto record_type_set = tes::to_record_type_set(tes::to_record_type(record_type_name));
+				if ((record_type_set & tes::extractable_record_types).none())
+				{
+					throw CLI::ValidationError("--types", std::format("{} records cannot be extracted.", record_type_name));
+				}
+				arguments.record_types |= record_type_set;
+			}
+		},
+		"Comma-separated record types to extract, such as AVIF,PERK. Defaults to all supported types except ACHR and REFR."
+	)
+		->delimiter(',');
+	app.add_flag(
+			"--lazy-decode", arguments.lazy_decode,
+			"Index all plugins first, and only decode the final version of each record instead of every version."
+	);
+	app.add_flag(
+			"--overrides", arguments.override_report,
+			"Write the plugins overriding each record into overrides.json, and whether their changes are lost."
+	);
+	app.add_flag(
+			"--dedupe-plugins", arguments.dedupe_plugins,
+			"Hash the contents of every plugin, and parse plugins with the same contents as another one only once. Cannot be "
+			"used with --lazy-decode."
+	);
+
+	auto* diff = app.add_subcommand("diff", "Compare the records of the profile against another profile or a snapshot.");
+	// Options of the main command can also be placed after the subcommand.
+	diff->fallthrough();
+	diff->callback([&arguments] { arguments.diff.enabled = true; });
+	auto* base_profile = diff->add_option(
+			"--base-profile", arguments.diff.base_profile_path, "Path to the Mod Organizer 2 profile to compare against."
+	);
+	diff->add_option("--base-snapshot", arguments.diff.base_snapshot_path, "Path to a snapshot to compare against.")
+			->excludes(base_profile);
+	diff->add_option("--save-snapshot", arguments.diff.save_snapshot_path, "Save a snapshot of the profile into a file.");
+
+	if constexpr (daemon::enabled)
+	{
+		auto* daemon_command =
+				app.add_subcommand("daemon", "Keep the records of the profile in memory and answer queries about them.");
+		daemon_command->fallthrough();
+		daemon_command->callback([&arguments] { arguments.daemon.enabled = true; });
+		daemon_command
+				->add_option("--socket", arguments.daemon.socket_path, "Path to the Unix domain socket receiving queries.")
+				->capture_default_str();
+	}
+
+	if constexpr (stats::enabled)
+	{
+		const std::map<std::string, stats::format_t> stats_formats{
+				{"table", stats::format_t::table},
+				{"json", stats::format_t::json},
+		};
+		app.add_flag_function(
+				"--stats",
+				[&arguments](const std::int64_t /*count*/)
+				{
+					if (arguments.stats_format == stats::format_t::none)
+					{
+						arguments.stats_format = stats::format_t::table;
+					}
+				},
+				"Show time and work spent on each task and plugin."
+		);
+		app.add_option("--stats-format", arguments.stats_format, "Statistics report format. Implies --stats.")
+				->transform(CLI::CheckedTransformer(stats_formats, CLI::ignore_case));
+		app.add_option("--trace", arguments.trace_path, "Write a trace of the run in Chrome trace event format.");
+	}
 }
 
 std::expected<arguments_t, std::string> validate_arguments(arguments_t arguments)
 {
 	namespace fs = std::filesystem;
-	if (!fs::exists(arguments.profile_path))
+	auto& batch_profile_paths = arguments.batch_profile_paths;
+	if (!batch_profile_paths.empty() && (arguments.diff.enabled || arguments.daemon.enabled))
+	{
+		return std::unexpected("Only a single profile can be used with the diff and daemon subcommands.");
+	}
+	if ((arguments.lazy_decode || arguments.override_report) &&
+			(!batch_profile_paths.empty() || arguments.diff.enabled || arguments.daemon.enabled))
+	{
+		return std::unexpected("--lazy-decode and --overrides can only be used when extracting a single profile.");
+	}
+	if (arguments.lazy_decode && arguments.dedupe_plugins)
 	{
-		return std::unexpected(std::format("Profile path {} does not exist.", arguments.profile_path.string()));
+		// The record index keeps every version of each record, so duplicate plugins cannot be left out of it.
+		return std::unexpected("--dedupe-plugins cannot be used with --lazy-decode.");
 	}
-	if (!fs::is_directory(arguments.profile_path))
+	std::unordered_set<std::string> profile_names;
+	const auto profile_paths =
+			batch_profile_paths.empty() ? std::span{&arguments.profile_path, 1Z} : std::span{batch_profile_paths};
+	for (auto& profile_path : profile_paths)
 	{
-		return std::unexpected(std::format("Profile path {} is not a directory.", arguments.profile_path.string()));
+		if (!fs::exists(profile_path))
+		{
+			return std::unexpected(std::format("Profile path {} does not exist.", profile_path.string()));
+		}
+		if (!fs::is_directory(profile_path))
+		{
+			return std::unexpected(std::format("Profile path {} is not a directory.", profile_path.string()));
+		}
+		if (batch_profile_paths.empty())
+		{
+			continue;
+		}
+		// The output of each batch profile is written into a folder with its name.
+		profile_path = fs::canonical(profile_path);
+		if (!profile_names.emplace(profile_path.filename().string()).second)
+		{
+			return std::unexpected(std::format("More than one profile is named {}.", profile_path.filename().string()));
+		}
 	}
 
 	if (!fs::exists(arguments.data_path))
@@ -51,6 +181,15 @@ std::expected<arguments_t, std::string> validate_arguments(arguments_t arguments
 		return std::unexpected(std::format("Mods {} is not a directory.", arguments.mods_path.string()));
 	}
 
+	if (arguments.daemon.enabled)
+	{
+		return arguments;
+	}
+
+	if (arguments.output_path.empty())
+	{
+		return std::unexpected("An output path is required.");
+	}
 	if (!fs::exists(arguments.output_path))
 	{
 		return std::unexpected(std::format("Output path {} does not exist.", arguments.output_path.string()));
@@ -60,6 +199,17 @@ std::expected<arguments_t, std::string> validate_arguments(arguments_t arguments
 		return std::unexpected(std::format("Output {} is not a directory.", arguments.output_path.string()));
 	}
 
+	if (const auto& base_profile_path = arguments.diff.base_profile_path;
+			!base_profile_path.empty() && !fs::is_directory(base_profile_path))
+	{
+		return std::unexpected(std::format("Base profile path {} is not a directory.", base_profile_path.string()));
+	}
+	if (const auto& base_snapshot_path = arguments.diff.base_snapshot_path;
+			!base_snapshot_path.empty() && !fs::is_regular_file(base_snapshot_path))
+	{
+		return std::unexpected(std::format("Base snapshot {} does not exist.", base_snapshot_path.string()));
+	}
+
 	return arguments;
 }
 
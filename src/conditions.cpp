@@ -0,0 +1,186 @@
+#include <josk/conditions.hpp>
+#include <josk/tes_format.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+using josk::tes::compare_op_t;
+
+/**
+ * Compares the value of each build against the same operand. Each operator gets its own branch-free loop, so that the
+ * compiler can vectorize all of them.
+ * @param values Value of each build.
+ * @param op Comparison operator.
+ * @param operand Value to compare against.
+ * @param results Receives 1 for each build satisfying the comparison, 0 otherwise.
+ */
+template <typename Value>
+void compare(
+		const std::span<const Value> values, const compare_op_t op, const float operand,
+		const std::span<std::uint8_t> results
+)
+{
+	const auto compare_each = [values, operand, results](const auto compare_values)
+	{
+		for (std::size_t index{}; index < results.size(); ++index)
+		{
+			const float value = values[index];
+			results[index] = compare_values(value, operand) ? std::uint8_t{1U} : std::uint8_t{0U};
+		}
+	};
+
+	switch (op)
+	{
+		case compare_op_t::equal:
+			compare_each(std::equal_to<>{});
+			break;
+		case compare_op_t::not_equal:
+			compare_each(std::not_equal_to<>{});
+			break;
+		case compare_op_t::greater:
+			compare_each(std::greater<>{});
+			break;
+		case compare_op_t::greater_equal:
+			compare_each(std::greater_equal<>{});
+			break;
+		case compare_op_t::less:
+			compare_each(std::less<>{});
+			break;
+		case compare_op_t::less_equal:
+			compare_each(std::less_equal<>{});
+			break;
+	}
+}
+
+/**
+ * Evaluates a single condition for every build of a batch.
+ * @param condition Condition to evaluate.
+ * @param batch Builds to evaluate.
+ * @param results Receives 1 for each build satisfying the condition, 0 otherwise.
+ */
+void evaluate_condition(
+		const josk::tes::condition_t& condition, const josk::conditions::build_batch_t& batch,
+		const std::span<std::uint8_t> results
+)
+{
+	using josk::tes::condition_function_t;
+
+	if (!josk::conditions::is_evaluable(condition))
+	{
+		std::ranges::fill(results, std::uint8_t{1U});
+		return;
+	}
+
+	switch (condition.function)
+	{
+		case condition_function_t::get_actor_value:
+		case condition_function_t::get_base_actor_value:
+		{
+			const auto actor_values = batch.actor_values.subspan(condition.param1 * batch.size, batch.size);
+			compare(actor_values, condition.op, condition.value, results);
+			break;
+		}
+		case condition_function_t::get_level:
+			compare(batch.levels, condition.op, condition.value, results);
+			break;
+		case condition_function_t::has_perk:
+		{
+			const auto itr = std::ranges::lower_bound(batch.perk_ids, condition.param1);
+			if (itr == batch.perk_ids.end() || *itr != condition.param1)
+			{
+				// Perks not tracked by the batch are not taken by any build.
+				constexpr std::uint8_t untracked_value{};
+				std::uint8_t untracked_result{};
+				compare(std::span{&untracked_value, 1Z}, condition.op, condition.value, std::span{&untracked_result, 1Z});
+				std::ranges::fill(results, untracked_result);
+				break;
+			}
+			const auto perk_index = static_cast<std::size_t>(std::distance(batch.perk_ids.begin(), itr));
+			compare(batch.perks.subspan(perk_index * batch.size, batch.size), condition.op, condition.value, results);
+			break;
+		}
+		default:
+			std::ranges::fill(results, std::uint8_t{1U});
+			break;
+	}
+}
+
+}
+
+namespace josk::conditions
+{
+
+bool is_evaluable(const tes::condition_t& condition) noexcept
+{
+	constexpr std::uint8_t unsupported_flags =
+			tes::condition_use_global_flag | tes::condition_swap_subject_and_target_flag;
+	if (condition.run_on != tes::condition_run_on_t::subject || (condition.flags & unsupported_flags) != 0U)
+	{
+		return false;
+	}
+
+	switch (condition.function)
+	{
+		case tes::condition_function_t::get_actor_value:
+		case tes::condition_function_t::get_base_actor_value:
+			return condition.param1 < actor_value_count;
+		case tes::condition_function_t::get_level:
+		case tes::condition_function_t::has_perk:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void evaluate(
+		const tes::condition_program_t& program, const build_batch_t& batch, const std::span<std::uint8_t> results
+)
+{
+	assert(results.size() == batch.size);
+	assert(batch.actor_values.size() == actor_value_count * batch.size);
+	assert(batch.levels.size() == batch.size);
+	assert(batch.perks.size() == batch.perk_ids.size() * batch.size);
+
+	std::ranges::fill(results, std::uint8_t{1U});
+	// Results of the OR group being evaluated, and of its current condition.
+	std::vector<std::uint8_t> group_results(batch.size);
+	std::vector<std::uint8_t> condition_results(batch.size);
+	bool is_group_open{};
+	for (const auto& condition : program.conditions)
+	{
+		evaluate_condition(condition, batch, condition_results);
+		for (std::size_t index{}; index < batch.size; ++index)
+		{
+			group_results[index] |= condition_results[index];
+		}
+		is_group_open = (condition.flags & tes::condition_or_flag) != 0U;
+		if (!is_group_open)
+		{
+			for (std::size_t index{}; index < batch.size; ++index)
+			{
+				results[index] &= group_results[index];
+			}
+			std::ranges::fill(group_results, std::uint8_t{});
+		}
+	}
+
+	// The last condition of a program may still have its OR flag set.
+	if (is_group_open)
+	{
+		for (std::size_t index{}; index < batch.size; ++index)
+		{
+			results[index] &= group_results[index];
+		}
+	}
+}
+
+}
@@ -0,0 +1,536 @@
+#include <josk/cli.hpp>
+#include <josk/daemon.hpp>
+#include <josk/json.hpp>
+#include <josk/record_json.hpp>
+#include <josk/session.hpp>
+#include <josk/tes_format.hpp>
+
+#include <charconv>
+#include <expected>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if JOSK_DAEMON
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <print>
+#include <utility>
+#include <vector>
+#endif
+
+namespace
+{
+
+std::string to_error_response(const std::string_view error)
+{
+	std::string output{"{\"error\":"};
+	josk::json::append_string(output, error);
+	output.push_back('}');
+	return output;
+}
+
+void append_winner(
+		std::string& output, const josk::tes::formid_t record_id, const josk::session::record_version_t& winner
+)
+{
+	std::format_to(
+			std::back_inserter(output), "{{\"record_id\":{},\"type\":\"{}\",\"plugin\":", record_id,
+			josk::tes::to_record_string(winner.location.record_type)
+	);
+	josk::json::append_string(output, winner.plugin->plugin.filename);
+	output.append(",\"record\":");
+	if (!josk::session::visit_record(
+					winner.plugin->records, winner.location,
+					[&output](const auto& record) { josk::json::append_record(output, record); }
+			))
+	{
+		output.append("null");
+	}
+	output.push_back('}');
+}
+
+}
+
+namespace josk::daemon
+{
+
+std::string query(const session::session_t& session, const std::string_view request)
+{
+	const auto separator = request.find(' ');
+	const auto command = request.substr(0Z, separator);
+	const auto argument = separator == std::string_view::npos ? std::string_view{} : request.substr(separator + 1Z);
+
+	std::string output;
+	if (command == "formid")
+	{
+		const auto digits = argument.starts_with("0x") || argument.starts_with("0X") ? argument.substr(2Z) : argument;
+		tes::formid_t record_id{};
+		const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), record_id, 16);
+		if (digits.empty() || error != std::errc{} || end != digits.data() + digits.size())
+		{
+			return to_error_response(std::format("Invalid formid {}.", argument));
+		}
+		if (const auto* winner = session.find_winner(record_id); winner != nullptr)
+		{
+			append_winner(output, record_id, *winner);
+		}
+		else
+		{
+			output.append("null");
+		}
+		return output;
+	}
+	if (command == "type")
+	{
+		const auto record_type = tes::to_record_type(argument);
+		if ((tes::to_record_type_set(record_type) & session.record_types()).none())
+		{
+			return to_error_response(std::format("{} records are not being extracted.", argument));
+		}
+		output.push_back('[');
+		for (bool first{true}; const auto record_id : session.record_ids(record_type))
+		{
+			if (!first)
+			{
+				output.push_back(',');
+			}
+			append_winner(output, record_id, *session.find_winner(record_id));
+			first = false;
+		}
+		output.push_back(']');
+		return output;
+	}
+	return to_error_response(std::format("Unknown query {}.", command));
+}
+
+}
+
+#if JOSK_DAEMON
+
+namespace
+{
+
+/** Set by the signal handler to stop the daemon. */
+volatile std::sig_atomic_t stop_requested{};
+
+extern "C" void request_stop(const int /*signal*/)
+{
+	stop_requested = 1;
+}
+
+/** Changes are refreshed after no further events have been received for this long. */
+constexpr auto refresh_delay = std::chrono::milliseconds{200};
+
+/** Clients sending longer lines are disconnected. */
+constexpr std::size_t max_request_size = 256Z;
+
+constexpr std::uint32_t watch_mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+/** Owns a file descriptor, closing it when going out of scope. */
+class file_descriptor final
+{
+	int _fd{-1};
+
+public:
+	explicit file_descriptor(const int fd) noexcept
+		: _fd{fd}
+	{
+	}
+
+	file_descriptor(const file_descriptor&) = delete;
+	file_descriptor& operator=(const file_descriptor&) = delete;
+	file_descriptor(file_descriptor&& other) noexcept
+		: _fd{std::exchange(other._fd, -1)}
+	{
+	}
+	file_descriptor& operator=(file_descriptor&& other) noexcept
+	{
+		std::swap(_fd, other._fd);
+		return *this;
+	}
+
+	~file_descriptor()
+	{
+		if (_fd >= 0)
+		{
+			::close(_fd);
+		}
+	}
+
+	[[nodiscard]] int get() const noexcept
+	{
+		return _fd;
+	}
+};
+
+std::string errno_message(const std::string_view action)
+{
+	return std::format("Could not {}: {}", action, std::strerror(errno));
+}
+
+/** Watches the folders which may contain the load order or plugins of a modlist. */
+class modlist_watcher final
+{
+	file_descriptor _inotify;
+	/** Watch of the mods folder. New mod folders created inside of it are also watched. */
+	int _mods_watch{-1};
+	std::filesystem::path _mods_path;
+
+public:
+	explicit modlist_watcher(file_descriptor inotify, std::filesystem::path mods_path)
+		: _inotify{std::move(inotify)}
+		, _mods_path{std::move(mods_path)}
+	{
+	}
+
+	[[nodiscard]] int fd() const noexcept
+	{
+		return _inotify.get();
+	}
+
+	std::expected<int, std::string> watch(const std::filesystem::path& path)
+	{
+		const auto watch_descriptor = ::inotify_add_watch(_inotify.get(), path.c_str(), watch_mask);
+		if (watch_descriptor < 0)
+		{
+			return std::unexpected(errno_message(std::format("watch {}", path.generic_string())));
+		}
+		return watch_descriptor;
+	}
+
+	std::expected<void, std::string> watch_modlist(const josk::cli::arguments_t& arguments)
+	{
+		for (const auto& path : {arguments.profile_path, arguments.data_path})
+		{
+			if (const auto result = watch(path); !result.has_value())
+			{
+				return std::unexpected(result.error());
+			}
+		}
+		const auto mods_watch = watch(_mods_path);
+		if (!mods_watch.has_value())
+		{
+			return std::unexpected(mods_watch.error());
+		}
+		_mods_watch = mods_watch.value();
+		// Plugins are placed in the root folder of each mod.
+		for (const auto& entry : std::filesystem::directory_iterator{_mods_path})
+		{
+			if (entry.is_directory())
+			{
+				if (const auto result = watch(entry.path()); !result.has_value())
+				{
+					return std::unexpected(result.error());
+				}
+			}
+		}
+		return {};
+	}
+
+	/**
+	 * Reads pending events, watching new mod folders.
+	 * @return True if any of the events may affect the modlist.
+	 */
+	bool read_events()
+	{
+		alignas(inotify_event) std::array<char, 4096Z> buffer{};
+		bool modified{};
+		for (auto size = ::read(_inotify.get(), buffer.data(), buffer.size()); size > 0;
+				 size = ::read(_inotify.get(), buffer.data(), buffer.size()))
+		{
+			for (std::size_t offset{}; offset + sizeof(inotify_event) <= static_cast<std::size_t>(size);)
+			{
+				inotify_event event{};
+				std::memcpy(&event, buffer.data() + offset, sizeof(inotify_event));
+				const std::string_view name{buffer.data() + offset + sizeof(inotify_event), event.len};
+				if (event.wd == _mods_watch && (event.mask & IN_ISDIR) != 0U &&
+						(event.mask & (IN_CREATE | IN_MOVED_TO)) != 0U)
+				{
+					// Errors are ignored, as the folder may have been removed already.
+					static_cast<void>(watch(_mods_path / name.substr(0Z, name.find('\0'))));
+				}
+				modified = true;
+				offset += sizeof(inotify_event) + event.len;
+			}
+		}
+		return modified;
+	}
+};
+
+/** Client connected to the query socket. */
+struct client_t final
+{
+	file_descriptor socket;
+	/** Data received which does not form a complete request yet. */
+	std::string pending;
+	/** Responses which the socket did not accept yet. */
+	std::string output;
+};
+
+/**
+ * Reads requests from a client, and queues the response of each complete one.
+ * @param session Session with the records of the modlist.
+ * @param client Client with pending data.
+ * @return False if the client must be disconnected.
+ */
+bool read_requests(const josk::session::session_t& session, client_t& client)
+{
+	std::array<char, 4096Z> buffer{};
+	const auto size = ::recv(client.socket.get(), buffer.data(), buffer.size(), 0);
+	if (size < 0)
+	{
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	}
+	if (size == 0)
+	{
+		return false;
+	}
+	client.pending.append(buffer.data(), static_cast<std::size_t>(size));
+
+	std::size_t request_begin{};
+	for (auto request_end = client.pending.find('\n'); request_end != std::string::npos;
+			 request_end = client.pending.find('\n', request_begin))
+	{
+		auto request = std::string_view{client.pending}.substr(request_begin, request_end - request_begin);
+		if (request.ends_with('\r'))
+		{
+			request.remove_suffix(1Z);
+		}
+		client.output.append(josk::daemon::query(session, request));
+		client.output.push_back('\n');
+		request_begin = request_end + 1Z;
+	}
+	client.pending.erase(0Z, request_begin);
+	return client.pending.size() <= max_request_size;
+}
+
+/**
+ * Sends as many queued responses as the socket of a client accepts without blocking.
+ * @param client Client with queued responses.
+ * @return False if the client must be disconnected.
+ */
+bool flush_client(client_t& client)
+{
+	std::size_t sent{};
+	while (sent < client.output.size())
+	{
+		const auto result =
+				::send(client.socket.get(), client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL);
+		if (result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				return false;
+			}
+			break;
+		}
+		sent += static_cast<std::size_t>(result);
+	}
+	client.output.erase(0Z, sent);
+	return true;
+}
+
+/**
+ * Serves a client after poll reported events on its socket. Requests are only read while no responses are queued, so
+ * a client which stops reading cannot make the daemon buffer an unbounded amount of responses.
+ * @param session Session with the records of the modlist.
+ * @param client Client to serve.
+ * @param events Events reported by poll.
+ * @return False if the client must be disconnected.
+ */
+bool serve_client(const josk::session::session_t& session, client_t& client, const short events)
+{
+	if (client.output.empty() && (events & (POLLIN | POLLHUP | POLLERR)) != 0 && !read_requests(session, client))
+	{
+		return false;
+	}
+	return flush_client(client);
+}
+
+std::expected<file_descriptor, std::string> listen_on(const std::filesystem::path& socket_path)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	const auto& native_path = socket_path.native();
+	if (native_path.size() >= sizeof(address.sun_path))
+	{
+		return std::unexpected(std::format("Socket path {} is too long.", socket_path.generic_string()));
+	}
+	std::ranges::copy(native_path, std::begin(address.sun_path));
+
+	// Sockets left behind by a previous run are replaced.
+	if (std::filesystem::is_socket(socket_path))
+	{
+		std::filesystem::remove(socket_path);
+	}
+	file_descriptor socket{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+	if (socket.get() < 0)
+	{
+		return std::unexpected(errno_message("create socket"));
+	}
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	if (::bind(socket.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		return std::unexpected(errno_message(std::format("bind socket {}", socket_path.generic_string())));
+	}
+	if (::listen(socket.get(), SOMAXCONN) != 0)
+	{
+		return std::unexpected(errno_message("listen on socket"));
+	}
+	return socket;
+}
+
+void print_refresh(const std::expected<josk::session::refresh_summary_t, std::string>& result)
+{
+	if (!result.has_value())
+	{
+		std::println(stderr, "{}", result.error());
+		return;
+	}
+	std::println(
+			"Parsed {} plugins, removed {} plugins and updated {} records{}.", result->parsed_plugins,
+			result->removed_plugins, result->updated_records, result->load_order_changed ? " after a load order change" : ""
+	);
+}
+
+}
+
+namespace josk::daemon
+{
+
+std::expected<void, std::string> run(cli::arguments_t arguments)
+{
+	modlist_watcher watcher{file_descriptor{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}, arguments.mods_path};
+	if (watcher.fd() < 0)
+	{
+		return std::unexpected(errno_message("initialize inotify"));
+	}
+	// Folders are watched before the first refresh, so that no change can be missed.
+	if (auto result = watcher.watch_modlist(arguments); !result.has_value())
+	{
+		return result;
+	}
+
+	const auto socket_path = arguments.daemon.socket_path;
+	session::session_t session{std::move(arguments)};
+	if (auto result = session.refresh(); result.has_value())
+	{
+		print_refresh(result);
+	}
+	else
+	{
+		return std::unexpected(std::move(result.error()));
+	}
+
+	auto listener = listen_on(socket_path);
+	if (!listener.has_value())
+	{
+		return std::unexpected(std::move(listener.error()));
+	}
+	std::println("Listening on {}.", socket_path.generic_string());
+
+	std::signal(SIGINT, request_stop);
+	std::signal(SIGTERM, request_stop);
+	std::vector<client_t> clients;
+	std::optional<std::chrono::steady_clock::time_point> refresh_time;
+	std::vector<pollfd> poll_fds;
+	while (stop_requested == 0)
+	{
+		poll_fds.clear();
+		poll_fds.emplace_back(watcher.fd(), POLLIN, 0);
+		poll_fds.emplace_back(listener->get(), POLLIN, 0);
+		for (const auto& client : clients)
+		{
+			poll_fds.emplace_back(client.socket.get(), client.output.empty() ? POLLIN : POLLOUT, 0);
+		}
+		int timeout{-1};
+		if (refresh_time.has_value())
+		{
+			const auto remaining = *refresh_time - std::chrono::steady_clock::now();
+			const auto remaining_ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+			timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining_ms, 0));
+		}
+
+		if (::poll(poll_fds.data(), poll_fds.size(), timeout) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return std::unexpected(errno_message("poll"));
+		}
+
+		if ((poll_fds[0Z].revents & POLLIN) != 0 && watcher.read_events())
+		{
+			// Editors and mod managers write files in several steps, which are handled by a single refresh.
+			refresh_time = std::chrono::steady_clock::now() + refresh_delay;
+		}
+		if (refresh_time.has_value() && std::chrono::steady_clock::now() >= *refresh_time)
+		{
+			refresh_time.reset();
+			print_refresh(session.refresh());
+		}
+
+		// Clients are served before accepting new ones, as accepting them changes the order of the list.
+		for (std::size_t index{}, client_index{}; index < clients.size(); ++client_index)
+		{
+			const auto revents = poll_fds[2Z + client_index].revents;
+			if (revents != 0 && !serve_client(session, clients[index], revents))
+			{
+				clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(index));
+				continue;
+			}
+			++index;
+		}
+		if ((poll_fds[1Z].revents & POLLIN) != 0)
+		{
+			// Client sockets never block, so that a slow client cannot stall the rest of them or the refreshes.
+			if (const auto client = ::accept4(listener->get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC); client >= 0)
+			{
+				clients.emplace_back(file_descriptor{client}, std::string{}, std::string{});
+			}
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::remove(socket_path, error);
+	return {};
+}
+
+}
+
+#else
+
+namespace josk::daemon
+{
+
+std::expected<void, std::string> run(cli::arguments_t /*arguments*/)
+{
+	return std::unexpected("josk was built without daemon support.");
+}
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include <josk/formid_table.hpp>
+#include <josk/tes_format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace
+{
+
+using josk::tes::formid_t;
+using josk::tes::priority_t;
+
+/** Each slot packs a formid in its upper half and a priority in its lower half. */
+using slot_t = std::uint64_t;
+/** invalid_formid is never claimed, so this value cannot represent a valid slot. */
+constexpr auto empty_slot = ~slot_t{};
+
+/** Slots probed in a segment before moving on to the next one. */
+constexpr std::size_t max_probes = 32Z;
+
+constexpr slot_t to_slot(const formid_t formid, const priority_t priority) noexcept
+{
+	return (slot_t{formid} << 32U) | slot_t{static_cast<std::uint32_t>(priority)};
+}
+
+constexpr formid_t slot_formid(const slot_t slot) noexcept
+{
+	return static_cast<formid_t>(slot >> 32U);
+}
+
+constexpr priority_t slot_priority(const slot_t slot) noexcept
+{
+	return static_cast<priority_t>(static_cast<std::uint32_t>(slot));
+}
+
+/** Fibonacci hashing. Formids of the same plugin are mostly sequential, and must be spread through the table. */
+constexpr std::size_t slot_hash(const formid_t formid) noexcept
+{
+	constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15U;
+	return static_cast<std::size_t>((std::uint64_t{formid} * multiplier) >> 32U);
+}
+
+static_assert(slot_formid(to_slot(0x00012E46U, 7)) == 0x00012E46U);
+static_assert(slot_priority(to_slot(0x00012E46U, 7)) == 7);
+static_assert(to_slot(josk::tes::invalid_formid, josk::tes::invalid_priority) == empty_slot);
+
+}
+
+namespace josk::tes
+{
+
+struct formid_winner_table::segment final
+{
+	std::size_t mask;
+	std::unique_ptr<std::atomic<slot_t>[]> slots;
+	/** Owned by this segment. Only set once, when a probe sequence of this segment is full. */
+	std::atomic<segment*> next{};
+
+	explicit segment(const std::size_t capacity)
+		: mask{capacity - 1Z}
+		, slots{std::make_unique<std::atomic<slot_t>[]>(capacity)}
+	{
+		for (std::size_t index{}; index < capacity; ++index)
+		{
+			slots[index].store(empty_slot, std::memory_order_relaxed);
+		}
+	}
+
+	segment(const segment&) = delete;
+	segment(segment&&) = delete;
+	segment& operator=(const segment&) = delete;
+	segment& operator=(segment&&) = delete;
+
+	~segment()
+	{
+		// Iterative deletion avoids deep recursion on long chains.
+		auto* current = next.exchange(nullptr, std::memory_order_relaxed);
+		while (current != nullptr)
+		{
+			auto* following = current->next.exchange(nullptr, std::memory_order_relaxed);
+			delete current;
+			current = following;
+		}
+	}
+
+	/** Returns the next segment, creating it if necessary. Each segment doubles the capacity of the previous one. */
+	segment* next_or_create()
+	{
+		auto* current = next.load(std::memory_order_acquire);
+		if (current != nullptr)
+		{
+			return current;
+		}
+		auto created = std::make_unique<segment>((mask + 1Z) * 2Z);
+		if (next.compare_exchange_strong(current, created.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			return created.release();
+		}
+		// Another thread created the segment first.
+		return current;
+	}
+};
+
+formid_winner_table::formid_winner_table(const std::size_t capacity)
+	: _head{std::make_unique<segment>(std::bit_ceil(std::max(capacity, max_probes)))}
+{
+}
+
+formid_winner_table::formid_winner_table(formid_winner_table&&) noexcept = default;
+formid_winner_table& formid_winner_table::operator=(formid_winner_table&&) noexcept = default;
+formid_winner_table::~formid_winner_table() = default;
+
+bool formid_winner_table::claim(const formid_t formid, const priority_t priority)
+{
+	assert(formid != invalid_formid);
+	const auto desired = to_slot(formid, priority);
+	for (auto* current_segment = _head.get();; current_segment = current_segment->next_or_create())
+	{
+		auto index = slot_hash(formid);
+		for (std::size_t probe{}; probe < max_probes; ++probe, ++index)
+		{
+			auto& slot = current_segment->slots[index & current_segment->mask];
+			auto current = slot.load(std::memory_order_acquire);
+			if (current == empty_slot &&
+					slot.compare_exchange_strong(current, desired, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				return true;
+			}
+			// Slots are never emptied. After a failed exchange, current holds the formid that won the slot.
+			if (slot_formid(current) != formid)
+			{
+				continue;
+			}
+			while (slot_priority(current) < priority)
+			{
+				if (slot.compare_exchange_weak(current, desired, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+}
+
+priority_t formid_winner_table::winner(const formid_t formid) const noexcept
+{
+	for (const auto* current_segment = _head.get(); current_segment != nullptr;
+			 current_segment = current_segment->next.load(std::memory_order_acquire))
+	{
+		auto index = slot_hash(formid);
+		for (std::size_t probe{}; probe < max_probes; ++probe, ++index)
+		{
+			const auto current = current_segment->slots[index & current_segment->mask].load(std::memory_order_acquire);
+			if (current == empty_slot)
+			{
+				// Claims always take the first empty slot of their probe sequence, and slots are never emptied.
+				return invalid_priority;
+			}
+			if (slot_formid(current) == formid)
+			{
+				return slot_priority(current);
+			}
+		}
+	}
+	return invalid_priority;
+}
+
+}
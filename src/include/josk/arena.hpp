@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace josk::memory
+{
+
+/** Memory resource forwarding all requests to an upstream resource, keeping count of them. Not thread-safe. */
+class counting_resource final : public std::pmr::memory_resource
+{
+	std::pmr::memory_resource* _upstream;
+	std::size_t _allocations{};
+	std::size_t _allocated_bytes{};
+
+public:
+	explicit counting_resource(std::pmr::memory_resource* upstream) noexcept;
+
+	/** Number of allocations requested since construction. */
+	[[nodiscard]] std::size_t allocations() const noexcept
+	{
+		return _allocations;
+	}
+
+	/** Number of bytes requested since construction. */
+	[[nodiscard]] std::size_t allocated_bytes() const noexcept
+	{
+		return _allocated_bytes;
+	}
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+/**
+ * Monotonic arena for transient allocations of a single job, such as parsing a plugin. Deallocation is a no-op, and
+ * all memory is released at once when the arena is reset. The initial buffer is kept between resets, so jobs fitting
+ * in it do not allocate from the global heap at all. Not thread-safe.
+ */
+class arena_t final
+{
+	std::unique_ptr<std::byte[]> _initial_buffer;
+	counting_resource _upstream;
+	std::pmr::monotonic_buffer_resource _resource;
+
+public:
+	/** Initial buffer size used by default. */
+	static constexpr std::size_t default_initial_size = 1024Z * 1024Z;
+
+	explicit arena_t(std::size_t initial_size = default_initial_size);
+
+	arena_t(const arena_t&) = delete;
+	arena_t(arena_t&&) = delete;
+	arena_t& operator=(const arena_t&) = delete;
+	arena_t& operator=(arena_t&&) = delete;
+	~arena_t() = default;
+
+	/** Memory resource to be used by containers and objects of the current job. */
+	[[nodiscard]] std::pmr::memory_resource* resource() noexcept
+	{
+		return &_resource;
+	}
+
+	/** Releases all allocations made since the last reset. Objects using the arena must have been destroyed. */
+	void reset() noexcept
+	{
+		_resource.release();
+	}
+
+	/** Number of allocations that the arena had to request from the global heap since construction. */
+	[[nodiscard]] std::size_t heap_allocations() const noexcept
+	{
+		return _upstream.allocations();
+	}
+};
+
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <josk/stats.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
 #include <expected>
 #include <filesystem>
 #include <string>
+#include <vector>
 
 namespace CLI
 {
@@ -11,12 +16,50 @@ class App;
 
 namespace josk::cli
 {
+/** Options of the diff subcommand. Without a base profile or snapshot, every record is reported as added. */
+struct diff_arguments_t final
+{
+	/** Set when the diff subcommand is requested. */
+	bool enabled{};
+	/** Profile compared against the main one. It shares the data and mods folders of the main profile. */
+	std::filesystem::path base_profile_path;
+	/** Snapshot saved by a previous run, compared against the main profile. */
+	std::filesystem::path base_snapshot_path;
+	/** If set, the snapshot of the main profile is saved into this file. */
+	std::filesystem::path save_snapshot_path;
+};
+
+/** Options of the daemon subcommand. */
+struct daemon_arguments_t final
+{
+	/** Set when the daemon subcommand is requested. */
+	bool enabled{};
+	/** Unix domain socket receiving queries. */
+	std::filesystem::path socket_path{"josk.sock"};
+};
+
 struct arguments_t final
 {
 	std::filesystem::path profile_path;
+	/** Profiles extracted in batch mode, when more than one is provided. The first one is also stored in profile_path. */
+	std::vector<std::filesystem::path> batch_profile_paths;
 	std::filesystem::path data_path;
 	std::filesystem::path mods_path;
 	std::filesystem::path output_path;
+	/** Record types to extract. */
+	tes::record_type_set_t record_types{tes::default_record_types};
+	/** Index all plugins first, and then decode only the final version of each record. */
+	bool lazy_decode{};
+	/** Write the override history of each record into overrides.json. */
+	bool override_report{};
+	/** Hash the contents of every plugin, so that byte-identical plugins are only parsed once. */
+	bool dedupe_plugins{};
+	/** Format of the statistics report shown after a run. */
+	stats::format_t stats_format{stats::format_t::none};
+	/** If set, a trace of the run is written into this file. */
+	std::filesystem::path trace_path;
+	diff_arguments_t diff;
+	daemon_arguments_t daemon;
 };
 
 void configure_cli(CLI::App& app, arguments_t& arguments);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <josk/tes_format.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace josk::conditions
+{
+
+/** Number of actor values defined by Skyrim. */
+constexpr std::size_t actor_value_count = 164Z;
+
+/**
+ * Character builds evaluated together. Values are stored by actor value and perk instead of by build, so that each
+ * condition reads contiguous memory.
+ */
+struct build_batch_t final
+{
+	/** Number of builds. */
+	std::size_t size{};
+	/** Base actor values. The value of actor value av for build b is at av * size + b. */
+	std::span<const float> actor_values;
+	/** Level of each build. */
+	std::span<const float> levels;
+	/** Sorted formids of the perks tracked by the batch. */
+	std::span<const tes::formid_t> perk_ids;
+	/** 1 if a build has a perk, 0 otherwise. The value of tracked perk p for build b is at p * size + b. */
+	std::span<const std::uint8_t> perks;
+};
+
+/**
+ * Checks if a condition can be evaluated from the data of a build batch. Only GetActorValue, GetBaseActorValue,
+ * GetLevel and HasPerk run on the subject and compared against a constant value can be evaluated.
+ * @param condition Condition to check.
+ * @return True if the condition can be evaluated.
+ */
+[[nodiscard]] bool is_evaluable(const tes::condition_t& condition) noexcept;
+
+/**
+ * Evaluates a condition program for every build of a batch in a single pass. Conditions which are not evaluable are
+ * considered satisfied, as they depend on the game state instead of on the build.
+ * @param program Program to evaluate.
+ * @param batch Builds to evaluate.
+ * @param results Receives 1 for each build satisfying the program, 0 otherwise. Must have batch.size elements.
+ */
+void evaluate(const tes::condition_program_t& program, const build_batch_t& batch, std::span<std::uint8_t> results);
+
+}
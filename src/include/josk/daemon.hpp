@@ -0,0 +1,34 @@
+#pragma once
+
+#include <josk/cli.hpp>
+#include <josk/config.hpp>
+#include <josk/session.hpp>
+
+#include <expected>
+#include <string>
+#include <string_view>
+
+namespace josk::daemon
+{
+
+/** True if josk was built with support for the daemon subcommand. */
+constexpr bool enabled = JOSK_DAEMON != 0;
+
+/**
+ * Answers a query about the records of a session. "formid <id>" finds the winning version of a record, with the
+ * formid in hexadecimal. "type <TYPE>" finds the winning version of every record of a type.
+ * @param session Session with the records of the modlist.
+ * @param request Query, without line terminators.
+ * @return JSON document with the result of the query, in a single line.
+ */
+[[nodiscard]] std::string query(const session::session_t& session, std::string_view request);
+
+/**
+ * Keeps the records of a modlist in memory and answers queries about them on a Unix domain socket, one per line. The
+ * profile, Data and mods folders are watched for changes, which refresh the session.
+ * @param arguments Validated arguments.
+ * @return Nothing after receiving a termination signal, or an error.
+ */
+std::expected<void, std::string> run(cli::arguments_t arguments);
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <josk/tes_format.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace josk::tes
+{
+
+/** Load order priority of a plugin. Records from plugins with higher priority override the rest. */
+using priority_t = std::int32_t;
+constexpr priority_t invalid_priority{-1};
+
+/**
+ * Concurrent map from formids to the highest priority of the plugins that claimed them. It is lock-free: slots are
+ * updated with atomic compare-and-swap operations, and a larger table is chained whenever a probe sequence is full.
+ */
+class formid_winner_table final
+{
+	struct segment;
+	std::unique_ptr<segment> _head;
+
+public:
+	/**
+	 * Creates an empty table.
+	 * @param capacity Initial amount of slots. Rounded up to a power of two.
+	 */
+	explicit formid_winner_table(std::size_t capacity);
+
+	formid_winner_table(const formid_winner_table&) = delete;
+	formid_winner_table(formid_winner_table&&) noexcept;
+	formid_winner_table& operator=(const formid_winner_table&) = delete;
+	formid_winner_table& operator=(formid_winner_table&&) noexcept;
+	~formid_winner_table();
+
+	/**
+	 * Claims a formid for a plugin, keeping it only if no plugin with higher or equal priority claimed it before.
+	 * @param formid Record identifier. Must not be invalid_formid.
+	 * @param priority Priority of the plugin containing the record.
+	 * @return True if priority is now the winner of the formid.
+	 */
+	bool claim(formid_t formid, priority_t priority);
+
+	/**
+	 * Checks the current winner of a formid.
+	 * @param formid Record identifier.
+	 * @return Highest priority claiming the formid, or invalid_priority if it has not been claimed.
+	 */
+	[[nodiscard]] priority_t winner(formid_t formid) const noexcept;
+
+	/**
+	 * Checks if a record can be skipped because it has already been claimed by a plugin with higher priority.
+	 * @param formid Record identifier.
+	 * @param priority Priority of the plugin containing the record.
+	 * @return True if the record has been claimed by a plugin with higher priority.
+	 */
+	[[nodiscard]] bool claimed_by_higher(formid_t formid, priority_t priority) const noexcept
+	{
+		return winner(formid) > priority;
+	}
+};
+
+}
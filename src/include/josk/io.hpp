@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace josk::io
+{
+
+/** Strategy used for reading plugin data from disk. */
+enum class backend_t : std::uint8_t
+{
+	/** Standard library file streams, available on every platform. */
+	portable,
+	/** Batched asynchronous reads using Linux io_uring. Requires building with JOSK_IO_URING. */
+	io_uring,
+};
+
+/**
+ * Returns a human-readable name of a backend.
+ * @param backend Backend to check.
+ * @return Backend name.
+ */
+[[nodiscard]] constexpr std::string_view to_backend_string(const backend_t backend) noexcept
+{
+	switch (backend)
+	{
+		case backend_t::portable:
+			return "portable";
+		case backend_t::io_uring:
+			return "io_uring";
+	}
+	return "none";
+}
+
+/** Requests with this size are read until the end of the file. */
+constexpr auto whole_file = std::numeric_limits<std::uint64_t>::max();
+
+/** Contiguous byte range of a file. */
+struct read_request_t final
+{
+	std::filesystem::path path;
+	std::uint64_t offset{};
+	std::uint64_t size{whole_file};
+};
+
+/** File contents loaded in memory. */
+using buffer_t = std::vector<char>;
+
+using read_result_t = std::expected<buffer_t, std::string>;
+
+/**
+ * Checks which is the preferred backend in the current build and system.
+ * @return io_uring if it was enabled in the build and the kernel allows its usage, portable otherwise.
+ */
+[[nodiscard]] backend_t available_backend() noexcept;
+
+/**
+ * Reads a batch of file ranges. Backends may submit all requests at once and complete them in any order. Requests
+ * reading from the same file share a single open file.
+ * If the requested backend cannot be used, the portable backend is used instead.
+ * @param requests File ranges to read.
+ * @param backend Preferred backend.
+ * @return One result per request, in the same order as the requests.
+ */
+[[nodiscard]] std::vector<read_result_t> read(std::span<const read_request_t> requests, backend_t backend);
+
+/**
+ * Decompresses a zlib stream whose decompressed size is known in advance.
+ * @param compressed_data zlib stream.
+ * @param destination Receives the decompressed data. Its size must be the expected decompressed size.
+ * @return Nothing, or a short description of the error.
+ */
+[[nodiscard]] std::expected<void, std::string> decompress(
+		std::span<const char> compressed_data, std::span<char> destination
+);
+
+/**
+ * Computes a fast, non-cryptographic 64-bit hash of a byte range.
+ * @param data Bytes to hash.
+ * @param seed Initial value of the hash.
+ * @return Hash of the bytes.
+ */
+[[nodiscard]] std::uint64_t hash_bytes(std::span<const char> data, std::uint64_t seed) noexcept;
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace josk::json
+{
+
+/**
+ * Appends a value as a quoted JSON string, escaping it as required. Trailing null characters are dropped. Values which
+ * are not valid UTF-8 are considered to use the Windows-1252 code page of the game, and are transcoded to UTF-8.
+ * @param output String receiving the value.
+ * @param value Value to append.
+ */
+void append_string(std::string& output, std::string_view value);
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <josk/config.hpp>
+
+#include <cstdint>
+
+namespace josk::memory
+{
+
+/** Global allocations are only counted when josk is built with JOSK_MEMORY_STATS. */
+constexpr bool accounting_enabled = JOSK_MEMORY_STATS != 0;
+
+/** Allocations requested through the global operator new. */
+struct allocation_counters_t final
+{
+	std::uint64_t allocations{};
+	std::uint64_t allocated_bytes{};
+};
+
+/**
+ * Allocations requested since the process started. Thread-safe.
+ * @return Allocation counters. Always zero if accounting is not enabled.
+ */
+[[nodiscard]] allocation_counters_t allocation_counters() noexcept;
+
+/**
+ * Peak resident set size of the process.
+ * @return Peak resident size in bytes, or zero if it is not available on this platform.
+ */
+[[nodiscard]] std::uint64_t peak_resident_bytes() noexcept;
+
+}
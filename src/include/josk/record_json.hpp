@@ -0,0 +1,37 @@
+#pragma once
+
+#include <josk/tes_format.hpp>
+
+#include <string>
+
+namespace josk::json
+{
+
+/**
+ * Appends the fields of a record, without the braces of the object containing them. Formids which are not set are
+ * written as null.
+ * @param output String receiving the fields.
+ * @param record Record to append.
+ */
+void append_record_fields(std::string& output, const tes::avif_record& record);
+void append_record_fields(std::string& output, const tes::perk_record& record);
+void append_record_fields(std::string& output, const tes::leveled_list_record& record);
+void append_record_fields(std::string& output, const tes::cobj_record& record);
+void append_record_fields(std::string& output, const tes::placed_reference& record);
+void append_record_fields(std::string& output, const tes::dial_record& record);
+void append_record_fields(std::string& output, const tes::info_record& record);
+
+/**
+ * Appends a record as a JSON object.
+ * @param output String receiving the record.
+ * @param record Record to append.
+ */
+template <typename Record>
+void append_record(std::string& output, const Record& record)
+{
+	output.push_back('{');
+	append_record_fields(output, record);
+	output.push_back('}');
+}
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <josk/arena.hpp>
+#include <josk/cli.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace josk::session
+{
+
+/** Location of a record inside the parsed records of its plugin. */
+struct record_location_t final
+{
+	tes::record_type_t record_type{tes::record_type_t::none};
+	std::size_t position{};
+};
+
+/** Size and modification time of a plugin file. Plugins whose file state did not change are not parsed again. */
+struct file_state_t final
+{
+	std::uintmax_t size{};
+	std::filesystem::file_time_type write_time;
+	bool operator==(const file_state_t&) const = default;
+};
+
+/** Plugin kept in memory, with every record it contains whether it wins or not. */
+struct loaded_plugin_t final
+{
+	task::plugin_t plugin;
+	file_state_t file;
+	tes::parsed_records_t records;
+	/** Location of each record of the plugin. */
+	std::unordered_map<tes::formid_t, record_location_t> locations;
+};
+
+/** Winning version of a record. */
+struct record_version_t final
+{
+	const loaded_plugin_t* plugin{};
+	record_location_t location;
+};
+
+/**
+ * Calls a function with a record of a plugin.
+ * @param records Records of a plugin.
+ * @param location Location of the record in them.
+ * @param function Function receiving a reference to the record.
+ * @return False if the record type of the location is not decoded by josk.
+ */
+template <typename Function>
+bool visit_record(const tes::parsed_records_t& records, const record_location_t location, Function&& function)
+{
+	using tes::record_type_t;
+	switch (location.record_type)
+	{
+		case record_type_t::avif:
+			function(records.avif_records[location.position]);
+			return true;
+		case record_type_t::perk:
+			function(records.perk_records[location.position]);
+			return true;
+		case record_type_t::lvli:
+		case record_type_t::lvln:
+		case record_type_t::lvsp:
+			function(records.leveled_list_records[location.position]);
+			return true;
+		case record_type_t::cobj:
+			function(records.cobj_records[location.position]);
+			return true;
+		case record_type_t::achr:
+		case record_type_t::refr:
+			function(records.placed_references[location.position]);
+			return true;
+		case record_type_t::dial:
+			function(records.dial_records[location.position]);
+			return true;
+		case record_type_t::info:
+			function(records.info_records[location.position]);
+			return true;
+		default:
+			return false;
+	}
+}
+
+/** Work done by a refresh of a session. */
+struct refresh_summary_t final
+{
+	std::size_t parsed_plugins{};
+	std::size_t removed_plugins{};
+	/** Records whose winning version was checked again. */
+	std::size_t updated_records{};
+	/** Load order changes require checking the winner of every record. */
+	bool load_order_changed{};
+};
+
+/**
+ * Records of a modlist kept in memory between runs in the same process. Each refresh only parses plugins which were
+ * added or modified since the previous one, and resolves again the winners of the records they contain. Parse worker
+ * arenas are also kept, so successive runs do not allocate them again.
+ */
+class session_t final
+{
+	cli::arguments_t _arguments;
+	std::unique_ptr<memory::arena_t[]> _arenas;
+	std::size_t _arena_count{};
+	/** Loaded plugins, by file name. */
+	std::unordered_map<std::string, std::unique_ptr<loaded_plugin_t>> _plugins;
+	/** Plugins containing a version of each record. */
+	std::unordered_map<tes::formid_t, std::vector<const loaded_plugin_t*>> _versions;
+	std::unordered_map<tes::formid_t, record_version_t> _winners;
+	/** Winning records of each type, sorted by formid. */
+	std::map<tes::record_type_t, std::set<tes::formid_t>> _type_winners;
+
+	void update_winner(tes::formid_t record_id);
+
+public:
+	/**
+	 * Creates an empty session. Records are only loaded after calling refresh.
+	 * @param arguments Validated arguments of the modlist.
+	 */
+	explicit session_t(cli::arguments_t arguments);
+
+	/**
+	 * Reads the load order again, and parses plugins which were added or modified since the last refresh. The session
+	 * is not changed if there is an error.
+	 * @return Work done by the refresh, or an error.
+	 */
+	std::expected<refresh_summary_t, std::string> refresh();
+
+	/**
+	 * Refreshes the session, and derives data from the winning version of each record.
+	 * @return Extracted data, equivalent to the one of a full parse of the modlist, or an error.
+	 */
+	std::expected<task::extracted_data_t, std::string> extract();
+
+	/**
+	 * Finds the winning version of a record.
+	 * @param record_id Record identifier.
+	 * @return Winning version, or nullptr if no plugin contains the record.
+	 */
+	[[nodiscard]] const record_version_t* find_winner(tes::formid_t record_id) const noexcept;
+
+	/**
+	 * Lists the records of a type.
+	 * @param record_type Record type to check.
+	 * @return Formids of the records whose winning version has this type, in ascending order.
+	 */
+	[[nodiscard]] std::vector<tes::formid_t> record_ids(tes::record_type_t record_type) const;
+
+	/**
+	 * Copies the winning version of each record.
+	 * @return Parsed records following load order rules, sorted by formid.
+	 */
+	[[nodiscard]] tes::parsed_records_t winning_records() const;
+
+	/** Record types loaded by the session. */
+	[[nodiscard]] tes::record_type_set_t record_types() const noexcept
+	{
+		return _arguments.record_types;
+	}
+};
+
+}
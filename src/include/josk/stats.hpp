@@ -0,0 +1,191 @@
+#pragma once
+
+#include <josk/config.hpp>
+#include <josk/memory_stats.hpp>
+#include <josk/trace.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace josk::stats
+{
+
+/** Statistics are only collected when josk is built with JOSK_STATS. Otherwise, all collection code is removed. */
+constexpr bool enabled = JOSK_STATS != 0;
+
+using steady_clock_t = std::chrono::steady_clock;
+
+/** Output format of the statistics report. */
+enum class format_t : std::uint8_t
+{
+	/** No report is generated. */
+	none,
+	/** Human-readable table. */
+	table,
+	/** Machine-readable JSON. */
+	json,
+};
+
+/** Wall time and allocations of a task. Allocations are only counted when built with JOSK_MEMORY_STATS. */
+struct stage_stats_t final
+{
+	std::string_view name;
+	steady_clock_t::duration duration{};
+	std::uint64_t allocations{};
+	std::uint64_t allocated_bytes{};
+};
+
+/** Memory retained by a data structure holding results. */
+struct container_stats_t final
+{
+	std::string_view name;
+	/** Number of elements. */
+	std::uint64_t size{};
+	/** Bytes owned by the container and its elements, including unused capacity. */
+	std::uint64_t retained_bytes{};
+};
+
+/** Work performed while parsing a single plugin. */
+struct plugin_stats_t final
+{
+	std::string filename;
+	std::uint64_t file_bytes{};
+	/** The plugin was not read, because a plugin with higher priority has the same contents. */
+	bool skipped_duplicate{};
+	/** Only the parts of the file which may contain requested record types are read. */
+	std::uint64_t bytes_read{};
+	std::uint64_t groups_visited{};
+	/** Groups skipped as a whole, because they cannot contain any requested record type. Includes unread top groups. */
+	std::uint64_t groups_skipped{};
+	/** Records of requested types found in the plugin. */
+	std::uint64_t records_seen{};
+	/** Records of this plugin that made it into the final output. */
+	std::uint64_t records_accepted{};
+	/** Records of this plugin replaced by a version with higher priority. */
+	std::uint64_t records_overridden{};
+	/** Records stored with zlib compression, which had to be decompressed before decoding them. */
+	std::uint64_t records_decompressed{};
+	/** Topic children groups parsed. Each one is processed as a unit, recycling its working memory afterwards. */
+	std::uint64_t topics{};
+	/** Largest amount of transient memory requested while parsing a single topic. */
+	std::uint64_t peak_topic_bytes{};
+	/** Transient allocations which did not fit in the arena of the parser, and had to be requested from the heap. */
+	std::uint64_t heap_fallbacks{};
+	steady_clock_t::duration parse_time{};
+};
+
+/** Statistics gathered during a run. */
+struct report_t final
+{
+	std::vector<stage_stats_t> stages;
+	/** Plugins in load order. */
+	std::vector<plugin_stats_t> plugins;
+	std::vector<container_stats_t> containers;
+	/** Peak resident set size of the process at the end of the last task. */
+	std::uint64_t peak_resident_bytes{};
+};
+
+/**
+ * Increments a counter if statistics are enabled.
+ * @param counter Counter to increment.
+ * @param amount Amount to add.
+ */
+constexpr void count(std::uint64_t& counter, [[maybe_unused]] const std::uint64_t amount = 1U) noexcept
+{
+	if constexpr (enabled)
+	{
+		counter += amount;
+	}
+}
+
+/**
+ * Statistics gathered by the current process. Tasks add their own entries as they run.
+ * Tasks must not run concurrently with each other, but they may add plugin entries from multiple threads.
+ */
+[[nodiscard]] const report_t& report() noexcept;
+
+/**
+ * Adds a task to the report, and updates the peak resident size of the process.
+ * @param stage Task statistics. Its name must be a string literal.
+ */
+void add_stage(const stage_stats_t& stage);
+
+/**
+ * Adds the memory retained by a data structure to the report.
+ * @param container Container statistics. Its name must be a string literal.
+ */
+void add_container(const container_stats_t& container);
+
+/** Bytes owned by a vector, including unused capacity. Memory owned by its elements is not included. */
+template <typename Value>
+[[nodiscard]] constexpr std::uint64_t retained_bytes(const std::vector<Value>& values) noexcept
+{
+	return values.capacity() * sizeof(Value);
+}
+
+/** Heap bytes owned by a string. Strings fitting in the small string buffer do not own any. */
+[[nodiscard]] inline std::uint64_t retained_bytes(const std::string& value) noexcept
+{
+	static const auto small_string_capacity = std::string{}.capacity();
+	return value.capacity() > small_string_capacity ? value.capacity() + 1U : 0U;
+}
+
+/**
+ * Adds plugin statistics to the report. Thread-safe.
+ * @param plugins Statistics of each plugin.
+ */
+void add_plugins(std::vector<plugin_stats_t> plugins);
+
+/** Measures the wall time of a task from construction to destruction, and adds it to the report and the trace. */
+class stage_timer final
+{
+	std::string_view _name;
+	steady_clock_t::time_point _start;
+	memory::allocation_counters_t _start_counters;
+	trace::scope _trace;
+
+public:
+	explicit stage_timer(const std::string_view name)
+		: _name{name}
+		, _trace{"stage", name}
+	{
+		if constexpr (enabled)
+		{
+			_start_counters = memory::allocation_counters();
+			_start = steady_clock_t::now();
+		}
+	}
+
+	stage_timer(const stage_timer&) = delete;
+	stage_timer(stage_timer&&) = delete;
+	stage_timer& operator=(const stage_timer&) = delete;
+	stage_timer& operator=(stage_timer&&) = delete;
+
+	~stage_timer()
+	{
+		if constexpr (enabled)
+		{
+			const auto duration = steady_clock_t::now() - _start;
+			const auto [allocations, allocated_bytes] = memory::allocation_counters();
+			add_stage({
+					.name = _name,
+					.duration = duration,
+					.allocations = allocations - _start_counters.allocations,
+					.allocated_bytes = allocated_bytes - _start_counters.allocated_bytes,
+			});
+		}
+	}
+};
+
+/**
+ * Formats a statistics report.
+ * @param report Report to format.
+ * @param format Output format. Must not be none.
+ * @return Formatted report.
+ */
+[[nodiscard]] std::string format_report(const report_t& report, format_t format);
+
+}
@@ -1,26 +1,36 @@
 #pragma once
 
+#include <josk/arena.hpp>
 #include <josk/cli.hpp>
 #include <josk/tes_parse.hpp>
 
+#include <array>
+#include <compare>
 #include <cstdint>
 #include <expected>
 #include <filesystem>
+#include <limits>
+#include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace josk::task
 {
 
-using order_t = std::int32_t;
-constexpr order_t invalid_order{-1};
+using order_t = tes::priority_t;
+constexpr order_t invalid_order{tes::invalid_priority};
 
 struct plugin_t final
 {
 	order_t order;
 	std::string filename;
 	std::filesystem::path path;
+	/** Size and hash of the whole file. Only set when contents are hashed, zero otherwise. */
+	std::uint64_t size{};
+	std::uint64_t content_hash{};
 	auto operator<=>(const plugin_t&) const = default;
 };
 
@@ -30,6 +40,283 @@ struct plugins_to_load_t final
 	std::filesystem::path mods_path;
 	/** Maps each plugin name to its priority. */
 	std::unordered_map<std::string, order_t> load_order;
+	/** Hash the contents of each plugin found, so that byte-identical plugins are only parsed once. */
+	bool hash_contents{};
+};
+
+/** Location of every version of the records extracted by josk. Records are only decoded when requested. */
+struct record_index_t final
+{
+	/** Plugins sorted by load order. */
+	std::vector<plugin_t> plugins;
+	/** Handles sorted by formid, and then by inverse priority. */
+	std::vector<tes::record_handle_t> handles;
+
+	/**
+	 * Finds all versions of a record.
+	 * @param record_id Record identifier.
+	 * @return Versions of the record, starting from the one with the highest priority.
+	 */
+	[[nodiscard]] std::span<const tes::record_handle_t> versions(tes::formid_t record_id) const noexcept;
+
+	/**
+	 * Finds the plugin that contains a record version.
+	 * @param handle Record version.
+	 * @return Plugin with the priority of the handle, or nullptr if it is not part of this index.
+	 */
+	[[nodiscard]] const plugin_t* find_plugin(const tes::record_handle_t& handle) const noexcept;
+
+	/**
+	 * Lists indexed records of a specific type.
+	 * @param record_type Record type to check.
+	 * @return Formids of every record of the requested type, in ascending order.
+	 */
+	[[nodiscard]] std::vector<tes::formid_t> record_ids(tes::record_type_t record_type) const;
+};
+
+/** Override history of a record with more than one version. */
+struct record_overrides_t final
+{
+	tes::formid_t record_id{tes::invalid_formid};
+	tes::record_type_t record_type{tes::record_type_t::none};
+	/** Position of the winning version in record_index_t::handles. The rest of versions follow it. */
+	std::uint32_t first_handle{};
+	std::uint32_t version_count{};
+	/** Overrides with the same fingerprint as the original version of the record. */
+	std::uint32_t identical_to_master{};
+	/** Overrides whose changes are lost, as they differ from both the original version and the winning version. */
+	std::uint32_t lost_overrides{};
+
+	/** True if the winning version discards changes made by other overrides. */
+	[[nodiscard]] bool is_conflict() const noexcept
+	{
+		return lost_overrides != 0U;
+	}
+};
+
+/** Override history of a load order. */
+struct override_report_t final
+{
+	/** Index containing every version of each record. */
+	record_index_t index;
+	/** Records with more than one version, sorted by formid. */
+	std::vector<record_overrides_t> records;
+};
+
+/** Indexed contents of a plugin, identified by its size and a hash of the whole file. */
+struct plugin_snapshot_t final
+{
+	std::string filename;
+	std::uint64_t size{};
+	std::uint64_t content_hash{};
+	/** Every version of a record found in the plugin. Only their formids, types and fingerprints are saved. */
+	std::vector<tes::record_handle_t> handles;
+};
+
+/** Indexed contents of every plugin of a load order. A saved snapshot can be compared against later runs. */
+struct modlist_snapshot_t final
+{
+	tes::record_type_set_t record_types;
+	/** Sorted by load order. The priority of each handle is the position of its plugin in this vector. */
+	std::vector<plugin_snapshot_t> plugins;
+};
+
+enum class record_change_kind_t : std::uint8_t
+{
+	added,
+	removed,
+	changed,
+};
+
+/** Change of the winning version of a record between two snapshots. */
+struct record_change_t final
+{
+	tes::formid_t record_id{tes::invalid_formid};
+	tes::record_type_t record_type{tes::record_type_t::none};
+	record_change_kind_t kind{record_change_kind_t::changed};
+	/** Position of the plugin of the winning version in each snapshot. invalid_plugin if the record is missing. */
+	std::uint32_t base_plugin{};
+	std::uint32_t target_plugin{};
+
+	static constexpr auto invalid_plugin = std::numeric_limits<std::uint32_t>::max();
+};
+
+/** Position of a record in the vector of its type of a parsed_records_t instance. */
+using record_position_t = std::uint32_t;
+constexpr auto invalid_record_position = std::numeric_limits<record_position_t>::max();
+
+/** Skill tree of an AVIF record, with its edges stored in compressed sparse row format. */
+struct perk_tree_t final
+{
+	/** Position of the AVIF record. */
+	record_position_t avif_position{invalid_record_position};
+	/**
+	 * Position of the perk record of each node, following the order of avif_record::perks. Nodes whose perk has not
+	 * been parsed have invalid_record_position.
+	 */
+	std::vector<record_position_t> nodes;
+	/** Nodes unlocked by node n are stored in children, between child_offsets[n] and child_offsets[n + 1]. */
+	std::vector<std::uint32_t> child_offsets;
+	std::vector<std::uint32_t> children;
+};
+
+/** Links between parsed AVIF and PERK records, resolved into record positions. */
+struct perk_graph_t final
+{
+	/** Position of the next rank of each perk record, or invalid_record_position. */
+	std::vector<record_position_t> next_ranks;
+	/** Prerequisites of perk p are stored in prerequisites, between prerequisite_offsets[p] and [p + 1]. */
+	std::vector<std::uint32_t> prerequisite_offsets;
+	std::vector<record_position_t> prerequisites;
+	/** Skill tree of each AVIF record, following the order of the AVIF records. */
+	std::vector<perk_tree_t> trees;
+
+	/**
+	 * Prerequisites of a perk which have been parsed.
+	 * @param perk_position Position of the perk record.
+	 * @return Positions of the prerequisite perk records.
+	 */
+	[[nodiscard]] std::span<const record_position_t> perk_prerequisites(record_position_t perk_position) const noexcept;
+};
+
+/** Expected amount of a record generated by a leveled list. */
+struct leveled_item_t final
+{
+	tes::formid_t record_id{tes::invalid_formid};
+	double count{};
+	[[nodiscard]] bool operator==(const leveled_item_t&) const noexcept = default;
+};
+
+/**
+ * Leveled list expanded into the expected amount of each record it generates, taking nested lists into account. The
+ * result only changes at a few levels, so a distribution is only stored for each one of them.
+ */
+struct flat_leveled_list_t final
+{
+	/** Sorted levels at which the distribution changes. Each distribution applies until the next level. */
+	std::vector<std::uint16_t> levels;
+	/** Items of the distribution of levels[n] are stored in items, between item_offsets[n] and [n + 1]. */
+	std::vector<std::uint32_t> item_offsets;
+	/** Sorted by formid within each distribution. */
+	std::vector<leveled_item_t> items;
+
+	/**
+	 * Distribution of the leveled list for a player level.
+	 * @param level Player level.
+	 * @return Expected amount of each generated record. Empty below the first level of the list.
+	 */
+	[[nodiscard]] std::span<const leveled_item_t> at_level(std::uint16_t level) const noexcept;
+};
+
+/** Maps formids to the records referencing them. Keys and the values of each key are stored contiguously. */
+struct inverted_index_t final
+{
+	/** Sorted formids. */
+	std::vector<tes::formid_t> keys;
+	/** Records referencing keys[n] are stored in values, between offsets[n] and offsets[n + 1]. */
+	std::vector<std::uint32_t> offsets;
+	/** Sorted record positions within each key. */
+	std::vector<record_position_t> values;
+
+	/**
+	 * Finds the records referencing a formid.
+	 * @param key Formid to look up.
+	 * @return Positions of the records referencing the formid. Empty if there are none.
+	 */
+	[[nodiscard]] std::span<const record_position_t> find(tes::formid_t key) const noexcept;
+};
+
+/** Pair of a formid and the position of a record referencing it. */
+using record_reference_t = std::pair<tes::formid_t, record_position_t>;
+
+/**
+ * Builds an inverted index from a list of references.
+ * @param references References to index, in any order. Duplicates are ignored.
+ * @return Inverted index.
+ */
+[[nodiscard]] inverted_index_t to_inverted_index(std::vector<record_reference_t> references);
+
+/** Reverse lookups of crafting recipes. Values are positions of COBJ records. */
+struct recipe_index_t final
+{
+	/** Recipes creating each record. */
+	inverted_index_t created_objects;
+	/** Recipes using each record as a component. */
+	inverted_index_t components;
+};
+
+/** Grid coordinates of an exterior cell. */
+struct cell_coordinates_t final
+{
+	std::int32_t x{};
+	std::int32_t y{};
+	[[nodiscard]] auto operator<=>(const cell_coordinates_t&) const noexcept = default;
+};
+
+/** Placed references of a worldspace, grouped by the exterior cell containing their position. */
+struct world_grid_t final
+{
+	tes::formid_t world_id{tes::invalid_formid};
+	/** Cells containing references, sorted by x and then by y. */
+	std::vector<cell_coordinates_t> cells;
+	/** References placed in cells[n] are stored in references, between offsets[n] and offsets[n + 1]. */
+	std::vector<std::uint32_t> offsets;
+	/** Positions of placed references. */
+	std::vector<record_position_t> references;
+
+	/**
+	 * Finds the references placed in a cell.
+	 * @param cell Cell coordinates.
+	 * @return Positions of the placed references. Empty if there are none.
+	 */
+	[[nodiscard]] std::span<const record_position_t> cell_references(cell_coordinates_t cell) const noexcept;
+
+	/**
+	 * Finds the references placed in a rectangle of cells. The references of each column of the rectangle are stored
+	 * contiguously, so this requires one binary search per column.
+	 * @param min Cell with the lowest coordinates of the rectangle.
+	 * @param max Cell with the highest coordinates of the rectangle, included in it.
+	 * @return Positions of the placed references, sorted by cell.
+	 */
+	[[nodiscard]] std::vector<record_position_t> range_references(cell_coordinates_t min, cell_coordinates_t max) const;
+};
+
+/** Placed references, indexed by their location. Values are positions of placed references. */
+struct reference_grid_t final
+{
+	/** Sorted by formid. */
+	std::vector<world_grid_t> worlds;
+	/** References placed in each interior cell. */
+	inverted_index_t interior_cells;
+
+	/**
+	 * Finds the grid of a worldspace.
+	 * @param world_id Formid of the WRLD record.
+	 * @return Grid of the worldspace, or nullptr if it does not contain any placed reference.
+	 */
+	[[nodiscard]] const world_grid_t* find_world(tes::formid_t world_id) const noexcept;
+};
+
+/**
+ * Exterior cell containing a position.
+ * @param position Position in game units.
+ * @return Cell coordinates.
+ */
+[[nodiscard]] cell_coordinates_t to_cell_coordinates(const std::array<float, 3Z>& position) noexcept;
+
+/** Parsed records, and the data structures derived from them. */
+struct extracted_data_t final
+{
+	tes::parsed_records_t records;
+	perk_graph_t perk_graph;
+	/** Flattened version of each leveled list, following the order of the leveled list records. */
+	std::vector<flat_leveled_list_t> leveled_lists;
+	recipe_index_t recipe_index;
+	reference_grid_t reference_grid;
+	/** INFO records of each DIAL record. */
+	inverted_index_t topic_infos;
+	/** Only present if it has been requested. */
+	std::optional<override_report_t> override_report;
 };
 
 /** Parse the file detailing plugin load order. */
@@ -38,7 +325,214 @@ std::expected<plugins_to_load_t, std::string> parse_load_order(cli::arguments_t
 /** List of plugin files to be loaded, sorted by inverse load order. */
 std::expected<std::vector<plugin_t>, std::string> find_plugins(plugins_to_load_t modlist);
 
-/** Loads plugin files and parses the final version of each record. */
-std::expected<tes::parsed_records_t, std::string> parse_plugins(const std::vector<plugin_t>& plugins);
+/**
+ * Reads plugin files concurrently, and sets their size and content hash. Plugins with the same size and hash are
+ * considered identical.
+ * @param plugins Plugins to hash.
+ * @return Hashed plugins, in the same order, or an error.
+ */
+std::expected<std::vector<plugin_t>, std::string> hash_plugins(std::vector<plugin_t> plugins);
+
+/**
+ * Loads plugin files and parses the final version of each record.
+ * @param plugins Plugins sorted by load order.
+ * @param record_types Record types to extract. Plugins and groups which cannot contain them are not read.
+ * @return Parsed records following load order rules, or an error.
+ */
+std::expected<tes::parsed_records_t, std::string> parse_plugins(
+		const std::vector<plugin_t>& plugins, tes::record_type_set_t record_types
+);
+
+/**
+ * Loads plugin files and parses every version of each record, keeping the records of each plugin apart. Plugins with
+ * hashed contents are only parsed once if more than one of them is byte-identical.
+ * @param plugins Plugins sorted by load order.
+ * @param record_types Record types to extract.
+ * @param arenas Arenas of the parse workers, one per worker. If empty, arenas are created for this call only.
+ * @return Records of each plugin, in the same order as the plugins, or an error.
+ */
+std::expected<std::vector<tes::parsed_records_t>, std::string> parse_plugins_separately(
+		const std::vector<plugin_t>& plugins, tes::record_type_set_t record_types, std::span<memory::arena_t> arenas = {}
+);
+
+/**
+ * Resolves every perk reference of the parsed records into record positions.
+ * @param records Parsed records following load order rules.
+ * @return Perk graph.
+ */
+[[nodiscard]] perk_graph_t build_perk_graph(const tes::parsed_records_t& records);
+
+/**
+ * Expands every leveled list into the expected amount of each record it generates at each level. Lists are processed
+ * as a DAG: each nested list is flattened once and reused by all lists containing it, and lists which do not depend on
+ * each other are flattened concurrently. References forming a cycle are ignored.
+ * @param records Parsed records following load order rules.
+ * @return Flattened version of each leveled list, following the order of the leveled list records.
+ */
+[[nodiscard]] std::vector<flat_leveled_list_t> flatten_leveled_lists(const tes::parsed_records_t& records);
+
+/**
+ * Indexes crafting recipes by the record they create and by each one of their components.
+ * @param records Parsed records following load order rules.
+ * @return Recipe index.
+ */
+[[nodiscard]] recipe_index_t build_recipe_index(const tes::parsed_records_t& records);
+
+/**
+ * Groups placed references by worldspace and exterior cell, and interior references by cell.
+ * @param records Parsed records following load order rules.
+ * @return Reference grid.
+ */
+[[nodiscard]] reference_grid_t build_reference_grid(const tes::parsed_records_t& records);
+
+/**
+ * Groups dialogue responses by the topic containing them.
+ * @param records Parsed records following load order rules.
+ * @return Inverted index from DIAL formids to the positions of their INFO records.
+ */
+[[nodiscard]] inverted_index_t index_topic_infos(const tes::parsed_records_t& records);
+
+/**
+ * Builds all data structures derived from the parsed records.
+ * @param records Parsed records following load order rules.
+ * @return Parsed records and derived data.
+ */
+[[nodiscard]] extracted_data_t derive_data(tes::parsed_records_t records);
+
+/**
+ * Writes extracted records and derived data as JSON files into the output folder.
+ * @param data Extracted data.
+ * @param output_path Output folder.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> write_output(const extracted_data_t& data, const std::filesystem::path& output_path);
+
+/**
+ * Loads plugin files and indexes every version of each record, without decoding them.
+ * @param plugins Plugins sorted by load order.
+ * @param record_types Record types to index. Plugins and groups which cannot contain them are not read.
+ * @return Record index, or an error.
+ */
+std::expected<record_index_t, std::string> index_plugins(
+		std::vector<plugin_t> plugins, tes::record_type_set_t record_types
+);
+
+/**
+ * Summarizes the override history of each record by comparing the fingerprints of its versions.
+ * @param index Record index.
+ * @return Records with more than one version, sorted by formid.
+ */
+[[nodiscard]] std::vector<record_overrides_t> build_override_report(const record_index_t& index);
+
+/**
+ * Indexes a load order and adds the override history of its records to the extracted data.
+ * @param data Data extracted from the load order.
+ * @param plugins Plugins sorted by load order.
+ * @param record_types Record types to index.
+ * @return Extracted data including the override report, or an error.
+ */
+std::expected<extracted_data_t, std::string> add_override_report(
+		extracted_data_t data, std::vector<plugin_t> plugins, tes::record_type_set_t record_types
+);
+
+/**
+ * Adds the override history of the records of an index to the extracted data.
+ * @param data Data extracted from the indexed load order.
+ * @param index Record index of the load order, such as the one used to materialize the data.
+ * @return Extracted data including the override report.
+ */
+extracted_data_t add_override_report(extracted_data_t data, record_index_t index);
+
+/**
+ * Indexes the plugins of a load order into a snapshot. Plugins with the same size and content hash as a plugin of the
+ * reusable snapshot are not parsed again.
+ * @param plugins Plugins sorted by load order.
+ * @param record_types Record types to index.
+ * @param reusable Snapshot whose plugins may be reused. May be null. It must contain the same record types.
+ * @return Snapshot, or an error.
+ */
+std::expected<modlist_snapshot_t, std::string> snapshot_plugins(
+		const std::vector<plugin_t>& plugins, tes::record_type_set_t record_types, const modlist_snapshot_t* reusable
+);
+
+/**
+ * Reads a snapshot saved by write_snapshot.
+ * @param path Path of the snapshot file.
+ * @return Snapshot, or an error.
+ */
+std::expected<modlist_snapshot_t, std::string> read_snapshot(const std::filesystem::path& path);
+
+/**
+ * Saves a snapshot into a binary file.
+ * @param snapshot Snapshot to save.
+ * @param path Path of the snapshot file.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> write_snapshot(const modlist_snapshot_t& snapshot, const std::filesystem::path& path);
+
+/**
+ * Compares the fingerprints of the winning version of each record of two snapshots.
+ * @param base Snapshot taken first.
+ * @param target Snapshot taken later.
+ * @return Added, removed and changed records, sorted by formid.
+ */
+[[nodiscard]] std::vector<record_change_t> diff_snapshots(
+		const modlist_snapshot_t& base, const modlist_snapshot_t& target
+);
+
+/**
+ * Extracts several profiles sharing the same Data and mods folders. Each plugin file is parsed once, even if it is part
+ * of more than one profile, and then load order rules are applied separately for each profile. The output of each
+ * profile is written into a folder with its name inside of the output folder.
+ * @param arguments Validated arguments, with the batch profiles.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> extract_profiles(cli::arguments_t arguments);
+
+/**
+ * Compares the records of the main profile against those of another profile or of a saved snapshot, writing the
+ * changes into diff.json in the output folder.
+ * @param arguments Validated arguments of the diff subcommand.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> diff_modlists(cli::arguments_t arguments);
+
+/**
+ * Decodes the final version of a set of records. Only the data of the requested records is read from disk.
+ * @param index Record index.
+ * @param record_ids Records to decode. Formids missing from the index are ignored.
+ * @return Decoded records following load order rules, or an error.
+ */
+std::expected<tes::parsed_records_t, std::string> materialize_records(
+		const record_index_t& index, std::span<const tes::formid_t> record_ids
+);
+
+/**
+ * Decodes the final version of every record of an index. Produces the same records as parse_plugins in a different
+ * order, but versions overridden by other plugins are never decoded.
+ * @param index Record index of a load order.
+ * @return Decoded records following load order rules, or an error.
+ */
+std::expected<tes::parsed_records_t, std::string> materialize_index(const record_index_t& index);
+
+/**
+ * Indexes a load order and then decodes the final version of every indexed record with materialize_index.
+ * @param plugins Plugins sorted by load order.
+ * @param record_types Record types to extract.
+ * @return Decoded records following load order rules, or an error.
+ */
+std::expected<tes::parsed_records_t, std::string> materialize_plugins(
+		const std::vector<plugin_t>& plugins, tes::record_type_set_t record_types
+);
+
+/**
+ * Decodes a single skill tree: its AVIF record, the perks it contains and all of their ranks.
+ * @param index Record index.
+ * @param avif_id Formid of the AVIF record.
+ * @return Decoded records, or an error.
+ */
+std::expected<tes::parsed_records_t, std::string> materialize_perk_tree(
+		const record_index_t& index, tes::formid_t avif_id
+);
 
 }
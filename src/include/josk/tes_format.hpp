@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
@@ -48,7 +49,7 @@ constexpr std::array<std::string_view, 121Z> record_type_str{
 /**
  * Converts a char[4] into the record type representation used by josk.
  * @param record_type_string Must have a size of 4Z.
- * @return none if any error occurred, record_type otherwise.
+ * @return none if any error occurred or the record type is unknown to josk, record_type otherwise.
  */
 [[nodiscard]] record_type_t to_record_type(std::string_view record_type_string) noexcept;
 
@@ -68,9 +69,66 @@ constexpr std::array<std::string_view, 121Z> record_type_str{
 	return record_type_str[record_type_index];
 }
 
+/** Set of record types, indexed by their record_type_t. */
+using record_type_set_t = std::bitset<record_type_str.size()>;
+
+/**
+ * Creates a set containing a single record type.
+ * @param record_type Record type to add. Ignored if it is none.
+ * @return Record type set.
+ */
+[[nodiscard]] constexpr record_type_set_t to_record_type_set(const record_type_t record_type) noexcept
+{
+	record_type_set_t set{};
+	if (const auto record_type_index = static_cast<std::size_t>(record_type); record_type_index < set.size())
+	{
+		set.set(record_type_index);
+	}
+	return set;
+}
+
+/** Group types, as they appear in GRUP headers. The meaning of the group label depends on its type. */
+enum class group_type_t : std::int32_t
+{
+	/** Label is the record type contained in the group. */
+	top = 0,
+	/** Label is the formid of the parent WRLD record. */
+	world_children = 1,
+	/** Label is the block number. */
+	interior_cell_block = 2,
+	/** Label is the sub-block number. */
+	interior_cell_sub_block = 3,
+	/** Label contains the grid Y and X coordinates of the block. */
+	exterior_cell_block = 4,
+	/** Label contains the grid Y and X coordinates of the sub-block. */
+	exterior_cell_sub_block = 5,
+	/** Label is the formid of the parent CELL record. */
+	cell_children = 6,
+	/** Label is the formid of the parent DIAL record. */
+	topic_children = 7,
+	/** Label is the formid of the parent CELL record. */
+	cell_persistent_children = 8,
+	/** Label is the formid of the parent CELL record. */
+	cell_temporary_children = 9,
+};
+
+/** Largest valid group_type_t value. */
+constexpr auto max_group_type = group_type_t::cell_temporary_children;
+
+/**
+ * Record types that may appear at any depth inside of a group. Used to skip whole subtrees without visiting them.
+ * @param group_type Type of the group.
+ * @param label_type For top groups, record type stored in their label. Ignored for other group types.
+ * @return Record types that can be found in the group and its subgroups.
+ */
+[[nodiscard]] record_type_set_t group_record_types(group_type_t group_type, record_type_t label_type) noexcept;
+
 /** Expresses record, group or field id sizes in a TES file. */
 constexpr std::size_t section_id_byte_size = 4Z;
 
+/** Record header flag of records whose data is compressed with zlib. */
+constexpr std::uint32_t compressed_record_flag = 0x00040000U;
+
 /** Form (or record) identifiers are unique identifiers for individual records. */
 using formid_t = std::uint32_t;
 constexpr auto invalid_formid = std::numeric_limits<formid_t>::max();
@@ -80,7 +138,12 @@ enum class field_type_t : std::uint8_t
 {
 	anam,
 	avsk,
+	bnam,
+	cis1,
+	cis2,
 	cnam,
+	cnto,
+	coct,
 	ctda,
 	data,
 	desc,
@@ -90,9 +153,18 @@ enum class field_type_t : std::uint8_t
 	hnam,
 	icon,
 	inam,
+	lvld,
+	lvlf,
+	lvlg,
+	lvlo,
+	nam1,
+	name,
 	nnam,
 	pnam,
+	qnam,
+	rnam,
 	snam,
+	trdt,
 	vmad,
 	vnam,
 	xnam,
@@ -101,11 +173,19 @@ enum class field_type_t : std::uint8_t
 };
 
 /** String representations of field types, as they appear in TES files. Indexed by their field_type_t. */
-constexpr std::array<std::string_view, 19Z> field_type_str{
-		"ANAM", "AVSK", "CNAM", "CTDA", "DATA", "DESC", "EDID", "FNAM", "FULL", "HNAM",
-		"ICON", "INAM", "NNAM", "PNAM", "SNAM", "VMAD", "VNAM", "XNAM", "YNAM",
+constexpr std::array<std::string_view, 33Z> field_type_str{
+		"ANAM", "AVSK", "BNAM", "CIS1", "CIS2", "CNAM", "CNTO", "COCT", "CTDA", "DATA", "DESC", "EDID", "FNAM", "FULL",
+		"HNAM", "ICON", "INAM", "LVLD", "LVLF", "LVLG", "LVLO", "NAM1", "NAME", "NNAM", "PNAM", "QNAM", "RNAM", "SNAM",
+		"TRDT", "VMAD", "VNAM", "XNAM", "YNAM",
 };
 
+/**
+ * Converts a char[4] into the field type representation used by josk.
+ * @param field_type_string Must have a size of 4Z.
+ * @return none if any error occurred or the field type is unknown to josk, field_type otherwise.
+ */
+[[nodiscard]] field_type_t to_field_type(std::string_view field_type_string) noexcept;
+
 /**
  * Returns the string representation of a field type.
  * @param field_type Type to check.
@@ -122,6 +202,79 @@ constexpr std::array<std::string_view, 19Z> field_type_str{
 	return field_type_str[field_type_index];
 }
 
+/** Comparison operators of conditions, stored in the upper three bits of the first byte of CTDA fields. */
+enum class compare_op_t : std::uint8_t
+{
+	equal = 0U,
+	not_equal = 1U,
+	greater = 2U,
+	greater_equal = 3U,
+	less = 4U,
+	less_equal = 5U,
+};
+
+/** Condition functions known by josk. Conditions keep the function index of any other function as it is. */
+enum class condition_function_t : std::uint16_t
+{
+	get_actor_value = 14U,
+	get_global_value = 74U,
+	get_level = 80U,
+	get_base_actor_value = 277U,
+	has_perk = 448U,
+};
+
+/** Reference on which the function of a condition is run. */
+enum class condition_run_on_t : std::uint8_t
+{
+	subject = 0U,
+	target = 1U,
+	reference = 2U,
+	combat_target = 3U,
+	linked_reference = 4U,
+	quest_alias = 5U,
+	package_data = 6U,
+	event_data = 7U,
+};
+
+/** Condition flags, stored in the lower five bits of the first byte of CTDA fields. */
+constexpr std::uint8_t condition_or_flag = 0x01U;
+constexpr std::uint8_t condition_use_aliases_flag = 0x02U;
+constexpr std::uint8_t condition_use_global_flag = 0x04U;
+constexpr std::uint8_t condition_use_pack_data_flag = 0x08U;
+constexpr std::uint8_t condition_swap_subject_and_target_flag = 0x10U;
+
+/** String index used by conditions without a string parameter. */
+constexpr std::uint16_t no_condition_string = std::numeric_limits<std::uint16_t>::max();
+
+/** Condition decoded from a CTDA field and its optional CIS1 and CIS2 string parameters. */
+struct condition_t final
+{
+	/** Comparison value. When condition_use_global_flag is set, its bits hold the formid of a GLOB record instead. */
+	float value{};
+	std::uint32_t param1{};
+	std::uint32_t param2{};
+	std::int32_t param3{-1};
+	formid_t reference{};
+	condition_function_t function{};
+	compare_op_t op{compare_op_t::equal};
+	std::uint8_t flags{};
+	condition_run_on_t run_on{condition_run_on_t::subject};
+	/** Index of the CIS1 parameter in the strings of the program, or no_condition_string. */
+	std::uint16_t string1{no_condition_string};
+	/** Index of the CIS2 parameter in the strings of the program, or no_condition_string. */
+	std::uint16_t string2{no_condition_string};
+};
+
+/**
+ * Conditions of a record in evaluation order, stored contiguously. Consecutive conditions with condition_or_flag are
+ * joined with the next one into an OR group, and the program is satisfied when all of its groups are.
+ */
+struct condition_program_t final
+{
+	std::vector<condition_t> conditions;
+	std::vector<std::string> strings;
+};
+
 enum class skill_category_t : std::uint8_t
 {
 	other = 0U,
@@ -130,6 +283,105 @@ enum class skill_category_t : std::uint8_t
 	stealth = 3U,
 };
 
+/** Leveled list flags, stored in LVLF fields. */
+constexpr std::uint8_t leveled_all_levels_flag = 0x01U;
+constexpr std::uint8_t leveled_each_item_in_count_flag = 0x02U;
+constexpr std::uint8_t leveled_use_all_flag = 0x04U;
+
+struct leveled_entry final
+{
+	/** Minimum level of the entry. */
+	std::uint16_t level{};
+	/** Formid of the generated record, which may be another leveled list. */
+	formid_t record_id{invalid_formid};
+	std::uint16_t count{};
+};
+
+/** Leveled item, actor or spell list. */
+struct leveled_list_record final
+{
+	formid_t record_id{invalid_formid};
+	/** LVLI, LVLN or LVSP. */
+	record_type_t record_type{record_type_t::none};
+	/** Chance of generating nothing, as a percentage. */
+	std::uint8_t chance_none{};
+	std::uint8_t flags{};
+	/** GLOB record overriding chance_none, or invalid_formid. */
+	formid_t chance_none_global{invalid_formid};
+	std::vector<leveled_entry> entries;
+};
+
+struct recipe_component final
+{
+	formid_t record_id{invalid_formid};
+	std::int32_t count{};
+};
+
+/** Constructible object record, describing a crafting recipe. */
+struct cobj_record final
+{
+	formid_t record_id{invalid_formid};
+	/** Record created by the recipe. */
+	formid_t created_object_id{invalid_formid};
+	/** Keyword of the workbench which can craft the recipe. */
+	formid_t workbench_keyword_id{invalid_formid};
+	std::uint16_t created_count{1U};
+	std::vector<recipe_component> components;
+	/** Requirements to craft the recipe. */
+	condition_program_t conditions;
+};
+
+/** Width and height of an exterior cell, in game units. */
+constexpr float exterior_cell_size = 4096.0F;
+
+/** Reference placed in a cell, decoded from REFR and ACHR records. */
+struct placed_reference final
+{
+	formid_t record_id{invalid_formid};
+	/** Record being placed. */
+	formid_t base_id{invalid_formid};
+	/** WRLD record containing the cell, or invalid_formid for interior cells. */
+	formid_t world_id{invalid_formid};
+	/** CELL record containing the reference. */
+	formid_t cell_id{invalid_formid};
+	/** REFR or ACHR. */
+	record_type_t record_type{record_type_t::none};
+	std::array<float, 3Z> position{};
+};
+
+/** Dialogue topic. Its responses are stored in INFO records placed in its topic children group. */
+struct dial_record final
+{
+	formid_t record_id{invalid_formid};
+	std::string name;
+	/** QUST record owning the topic, or invalid_formid. */
+	formid_t quest_id{invalid_formid};
+	std::uint8_t category{};
+	std::uint16_t subtype{};
+};
+
+/** Line of a dialogue response. */
+struct info_response final
+{
+	std::uint8_t response_number{};
+	std::string text;
+};
+
+/** Dialogue response, decoded from an INFO record. */
+struct info_record final
+{
+	formid_t record_id{invalid_formid};
+	/** DIAL record owning the response, taken from the group containing it. */
+	formid_t topic_id{invalid_formid};
+	/** INFO record shown before this one, or invalid_formid. */
+	formid_t previous_info_id{invalid_formid};
+	/** Text chosen by the player to get this response. */
+	std::string prompt;
+	std::vector<info_response> responses;
+	/** Requirements for the response to be chosen. */
+	condition_program_t conditions;
+};
+
 struct perk_record final
 {
 	formid_t record_id{invalid_formid};
@@ -137,6 +389,8 @@ struct perk_record final
 	std::string description;
 	std::uint8_t skill_req{};
 	std::vector<formid_t> prereq_perk_ids;
+	/** Requirements to take the perk. */
+	condition_program_t conditions;
 	formid_t next_perk_id{invalid_formid};
 };
 
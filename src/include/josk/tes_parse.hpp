@@ -1,9 +1,18 @@
 #pragma once
 
+#include <josk/formid_table.hpp>
+#include <josk/io.hpp>
+#include <josk/stats.hpp>
 #include <josk/tes_format.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -12,27 +21,292 @@
 namespace josk::tes
 {
 
-/** Parsed records gathered from all modlist plugins following load order rules. */
+/** How parsers handle records of the types extracted by josk. */
+enum class parse_mode_t : std::uint8_t
+{
+	/** Records are decoded while the plugin is parsed. */
+	decode,
+	/** Only a handle to each version of a record is stored. Records can be decoded later with decode_record. */
+	index,
+};
+
+/** Record types extracted unless requested otherwise. */
+constexpr auto default_record_types =
+		to_record_type_set(record_type_t::avif) | to_record_type_set(record_type_t::cobj) |
+		to_record_type_set(record_type_t::dial) | to_record_type_set(record_type_t::info) |
+		to_record_type_set(record_type_t::lvli) | to_record_type_set(record_type_t::lvln) |
+		to_record_type_set(record_type_t::lvsp) | to_record_type_set(record_type_t::perk);
+
+/** Record types that josk is able to decode. Placed references require walking every cell, so they are opt-in. */
+constexpr auto extractable_record_types =
+		default_record_types | to_record_type_set(record_type_t::achr) | to_record_type_set(record_type_t::refr);
+
+/** Options shared by all parsers of a run. */
+struct parse_options_t final
+{
+	parse_mode_t mode{parse_mode_t::decode};
+	/** Records of other types are skipped, as well as any group which cannot contain any of these types. */
+	record_type_set_t record_types{default_record_types};
+	/** Records claimed by plugins with higher priority are skipped. If false, every version is decoded. */
+	bool skip_claimed{true};
+};
+
+/** 64-bit hash identifying the contents of a version of a record. */
+using fingerprint_t = std::uint64_t;
+
+/**
+ * Computes the fingerprint of a version of a record. The rest of its header, such as version control information, is
+ * ignored, as it changes whenever a plugin is saved again.
+ * @param record_flags Flags of the record header.
+ * @param record_data Data of the record, as stored in the plugin file.
+ * @return Fingerprint of the record.
+ */
+[[nodiscard]] fingerprint_t record_fingerprint(std::uint32_t record_flags, std::span<const char> record_data) noexcept;
+
+/** Location of a version of a record inside of a plugin file. */
+struct record_handle_t final
+{
+	formid_t record_id{invalid_formid};
+	record_type_t record_type{record_type_t::none};
+	/** Priority of the plugin containing this version. It also identifies the plugin. */
+	priority_t priority{invalid_priority};
+	/** Records owning the groups containing this version, or invalid_formid. Required to decode references and INFO. */
+	formid_t world_id{invalid_formid};
+	formid_t cell_id{invalid_formid};
+	formid_t topic_id{invalid_formid};
+	/** File position of the record data, right after its header. */
+	std::uint64_t offset{};
+	/** Size of the record data. */
+	std::uint32_t size{};
+	/** Flags of the record header. */
+	std::uint32_t flags{};
+	/** Fingerprint of the record flags and data. Versions with the same fingerprint are considered identical. */
+	fingerprint_t fingerprint{};
+};
+
+/** Part of a plugin file loaded into memory, placed at a position of the plugin buffer. */
+struct plugin_segment_t final
+{
+	std::uint64_t buffer_offset{};
+	std::uint64_t file_offset{};
+};
+
+/** Contents of a plugin file loaded into memory. It may only contain the TES4 record and some of its top groups. */
+struct plugin_data_t final
+{
+	io::buffer_t buffer;
+	/** Sorted by buffer offset. Empty if the buffer contains the whole file. */
+	std::vector<plugin_segment_t> segments;
+};
+
+/** Location of a top group in a plugin file. */
+struct top_group_t final
+{
+	/** Record type in the group label. */
+	record_type_t label_type{record_type_t::none};
+	/** File position of the group header. */
+	std::uint64_t offset{};
+	/** Size of the group, including its header. */
+	std::uint64_t size{};
+};
+
+/** Top level structure of a plugin file. */
+struct plugin_layout_t final
+{
+	/** Size of the TES4 record, including its header. Top groups start right after it. */
+	std::uint64_t header_size{};
+	std::vector<top_group_t> groups;
+};
+
+/**
+ * Reads the headers of the TES4 record and each top group of a plugin, without reading the records they contain.
+ * @param path Path of the plugin file.
+ * @return Plugin layout, or an error.
+ */
+std::expected<plugin_layout_t, std::string> scan_plugin_layout(const std::filesystem::path& path);
+
+/** Record read by a record_reader. */
+struct record_view_t final
+{
+	record_type_t record_type{record_type_t::none};
+	formid_t record_id{invalid_formid};
+	std::uint32_t flags{};
+	/** Records owning the groups containing this record, or invalid_formid. Required to decode references and INFO. */
+	formid_t world_id{invalid_formid};
+	formid_t cell_id{invalid_formid};
+	formid_t topic_id{invalid_formid};
+	/** File position of the record data, right after its header. */
+	std::uint64_t offset{};
+	/**
+	 * Record data as stored in the plugin file. It is still compressed if flags contain compressed_record_flag. Only
+	 * valid until the reader advances to the next record.
+	 */
+	std::span<const char> data;
+};
+
+/**
+ * Reads the records of a plugin file on demand, in file order. Groups which cannot contain any of the requested record
+ * types are skipped without reading them, and so is the data of records of other types. Consumers can stop at any
+ * record, and the rest of the file is not read. Record data can be decoded with decode_record, along with the owners of
+ * the groups containing it.
+ */
+class record_reader final
+{
+	/** Group entered by the reader, and the records owning it or one of the groups containing it. */
+	struct open_group_t final
+	{
+		/** File position right after the end of the group. */
+		std::uint64_t end{};
+		formid_t world_id{invalid_formid};
+		formid_t cell_id{invalid_formid};
+		formid_t topic_id{invalid_formid};
+	};
+
+	std::ifstream _file;
+	std::string _path;
+	std::uint64_t _file_size{};
+	/** File position of the next section header. */
+	std::uint64_t _offset{};
+	record_type_set_t _record_types;
+	/** Groups containing the next section, from the outermost one. */
+	std::vector<open_group_t> _groups;
+	io::buffer_t _data;
+	record_view_t _current;
+	std::string _error;
+	bool _started{};
+	bool _done{};
+
+	record_reader(std::ifstream file, std::string path, std::uint64_t file_size, record_type_set_t record_types);
+	bool fail(std::string error);
+
+public:
+	/** Input iterator over the records of a reader. Advancing it invalidates the data of the previous record. */
+	class iterator final
+	{
+		record_reader* _reader{};
+
+	public:
+		using value_type = record_view_t;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+
+		explicit iterator(record_reader& reader) noexcept
+			: _reader{&reader}
+		{
+		}
+
+		const record_view_t& operator*() const noexcept
+		{
+			return _reader->_current;
+		}
+
+		const record_view_t* operator->() const noexcept
+		{
+			return &_reader->_current;
+		}
+
+		iterator& operator++()
+		{
+			_reader->next();
+			return *this;
+		}
+
+		void operator++(int)
+		{
+			_reader->next();
+		}
+
+		bool operator==(std::default_sentinel_t /*sentinel*/) const noexcept
+		{
+			return _reader->_done;
+		}
+	};
+
+	/**
+	 * Opens a plugin file and reads its TES4 record header.
+	 * @param path Path of the plugin file.
+	 * @param record_types Record types to read.
+	 * @return Reader positioned before the first record, or an error.
+	 */
+	static std::expected<record_reader, std::string> open(
+			const std::filesystem::path& path, record_type_set_t record_types
+	);
+
+	/**
+	 * Advances to the next record of a requested type.
+	 * @return True if a record was read, false at the end of the file or after an error.
+	 */
+	bool next();
+
+	/** Last record read by next. */
+	[[nodiscard]] const record_view_t& current() const noexcept
+	{
+		return _current;
+	}
+
+	/** Error which stopped the reader, or an empty string. */
+	[[nodiscard]] const std::string& error() const noexcept
+	{
+		return _error;
+	}
+
+	/** Reads the first record, unless the reader already advanced. */
+	iterator begin()
+	{
+		if (!_started)
+		{
+			next();
+		}
+		return iterator{*this};
+	}
+
+	[[nodiscard]] std::default_sentinel_t end() const noexcept
+	{
+		return std::default_sentinel;
+	}
+};
+
+/** Parsed records gathered from one or more plugins. Once merged, it follows load order rules. */
 struct parsed_records_t final
 {
-	/** Any records in this set will not be parsed again. */
+	/** Formids of all records contained in this instance. */
 	std::unordered_set<formid_t> parsed_record_ids;
 	std::vector<avif_record> avif_records;
 	std::vector<perk_record> perk_records;
+	std::vector<leveled_list_record> leveled_list_records;
+	std::vector<cobj_record> cobj_records;
+	std::vector<placed_reference> placed_references;
+	std::vector<dial_record> dial_records;
+	std::vector<info_record> info_records;
+	/** Filled instead of the record vectors when using parse_mode_t::index. */
+	std::vector<record_handle_t> record_handles;
 };
 
 /** TES file parser implementation. Must be passed to the next file parsing task and not be handled outside of them. */
 struct parser;
 
 /**
- * Opens a TES plugin file with a parser. parsed_records must exist for the entire parser lifetime.
- * @param path Path to existing regular file that should be a plugin file.
+ * Opens a TES plugin file with a parser. parsed_records and winners must exist for the entire parser lifetime.
+ * Parsers of different plugins may run concurrently as long as each one has its own parsed_records instance.
+ * @param path Path of the plugin file, used in reports.
  * @param filename File name identifier used as an identifier on reports.
- * @param parsed_records Records parsed on plugins with higher load order than this one.
+ * @param priority Load order priority of the plugin.
+ * @param data Contents of the plugin file. The parser takes ownership of them.
+ * @param parsed_records Records accepted from this plugin will be placed here.
+ * @param winners Shared table of formids claimed by each plugin. Records claimed by plugins with higher priority are
+ * skipped without being decoded.
+ * @param arena Memory resource backing the parser and its transient allocations. It must outlive the parser, and it
+ * can be released wholesale after closing it. Only accepted records are copied out of it.
+ * @param options Parse options. Must exist for the entire parser lifetime.
+ * @param stats Statistics of the plugin, updated during parsing. May be null. Must exist for the entire parser
+ * lifetime.
  * @return TES plugin parser.
  */
 std::expected<parser*, std::string> open_plugin(
-		const std::filesystem::path& path, std::string_view filename, parsed_records_t& parsed_records
+		const std::filesystem::path& path, std::string_view filename, priority_t priority, plugin_data_t data,
+		parsed_records_t& parsed_records, formid_winner_table& winners, std::pmr::memory_resource* arena,
+		const parse_options_t& options, stats::plugin_stats_t* stats
 );
 
 /**
@@ -49,4 +323,18 @@ std::expected<parser*, std::string> parse_plugin(parser* parser_ptr);
  */
 std::expected<void, std::string> close_plugin(parser* parser_ptr);
 
+/**
+ * Decodes a single version of a record from its data.
+ * @param handle Handle of the record version, obtained with parse_mode_t::index.
+ * @param filename File name of the plugin containing the record, used in reports.
+ * @param data Record data, as described by the handle.
+ * @param parsed_records The record will be placed here if it is accepted.
+ * @param arena Memory resource for transient allocations. It can be released after this call.
+ * @return True if the record was accepted, false if this version must be ignored, or an error.
+ */
+std::expected<bool, std::string> decode_record(
+		const record_handle_t& handle, std::string_view filename, io::buffer_t data, parsed_records_t& parsed_records,
+		std::pmr::memory_resource* arena
+);
+
 }
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <josk/config.hpp>
+
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace josk::trace
+{
+
+/** Tracing is part of the statistics collected when josk is built with JOSK_STATS. */
+constexpr bool enabled = JOSK_STATS != 0;
+
+/**
+ * Starts recording trace events. Events are only recorded when josk is built with JOSK_STATS.
+ * Must be called before any task starts running.
+ */
+void start();
+
+/** True if trace events are being recorded. */
+[[nodiscard]] bool active() noexcept;
+
+/**
+ * Records the beginning of an event on the current thread. Each thread records into its own buffer.
+ * @param category Event category. Must be a string literal.
+ * @param name Event name.
+ */
+void begin(std::string_view category, std::string_view name);
+
+/** Records the end of the last event which began on the current thread. */
+void end();
+
+/**
+ * Writes all recorded events in Chrome trace event format. Threads which recorded events must have finished their
+ * work before calling this function.
+ * @param path Output file path.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> write(const std::filesystem::path& path);
+
+/** Records an event spanning from construction to destruction, if tracing is active. */
+class scope final
+{
+	bool _active{};
+
+public:
+	scope(const std::string_view category, const std::string_view name)
+	{
+		if constexpr (enabled)
+		{
+			_active = active();
+			if (_active)
+			{
+				begin(category, name);
+			}
+		}
+	}
+
+	scope(const scope&) = delete;
+	scope(scope&&) = delete;
+	scope& operator=(const scope&) = delete;
+	scope& operator=(scope&&) = delete;
+
+	~scope()
+	{
+		if constexpr (enabled)
+		{
+			if (_active)
+			{
+				end();
+			}
+		}
+	}
+};
+
+}
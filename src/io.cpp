@@ -0,0 +1,565 @@
+#include <josk/config.hpp>
+#include <josk/io.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <numeric>
+#include <span>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#include <zlib.h>
+
+#if JOSK_IO_URING
+#include <fcntl.h>
+#include <liburing.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <optional>
+#include <utility>
+#endif
+
+namespace
+{
+
+namespace fs = std::filesystem;
+using josk::io::buffer_t;
+using josk::io::read_request_t;
+using josk::io::read_result_t;
+
+/** Indices of the requests reading from the same file. */
+using file_requests_t = std::vector<std::size_t>;
+
+/**
+ * Groups requests by the file they read from, so that each file is opened only once per batch.
+ * @param requests File ranges to read.
+ * @return Requests of each file, in offset order.
+ */
+std::vector<file_requests_t> group_by_file(const std::span<const read_request_t> requests)
+{
+	std::vector<std::size_t> request_indices(requests.size());
+	std::iota(request_indices.begin(), request_indices.end(), std::size_t{});
+	std::ranges::sort(
+			request_indices, {},
+			[requests](const std::size_t request_index)
+			{ return std::tie(requests[request_index].path, requests[request_index].offset); }
+	);
+
+	std::vector<file_requests_t> files;
+	for (const auto request_index : request_indices)
+	{
+		if (files.empty() || requests[files.back().front()].path != requests[request_index].path)
+		{
+			files.emplace_back();
+		}
+		files.back().emplace_back(request_index);
+	}
+	return files;
+}
+
+/**
+ * Validates the range of a request against the current size of its file.
+ * @param request Request to check.
+ * @param file_size Size of the file, in bytes.
+ * @return Number of bytes that must be read, or an error.
+ */
+std::expected<std::uint64_t, std::string> request_size(const read_request_t& request, const std::uint64_t file_size)
+{
+	if (request.offset > file_size)
+	{
+		return std::unexpected(
+				std::format("Read offset 0x{:x} is past the end of file {}.", request.offset, request.path.string())
+		);
+	}
+
+	const auto remaining_size = file_size - request.offset;
+	if (request.size == josk::io::whole_file)
+	{
+		return remaining_size;
+	}
+	if (request.size > remaining_size)
+	{
+		return std::unexpected(
+				std::format(
+						"Read of 0x{:x} bytes at 0x{:x} is past the end of file {}.", request.size, request.offset,
+						request.path.string()
+				)
+		);
+	}
+	return request.size;
+}
+
+/**
+ * Reads all ranges of a single file, sharing one stream between them.
+ * @param requests File ranges to read.
+ * @param file_requests Requests reading from the file.
+ * @param results Results of all requests, where the results of the file are stored.
+ */
+void read_portable(
+		const std::span<const read_request_t> requests, const file_requests_t& file_requests,
+		const std::span<read_result_t> results
+)
+{
+	const auto& path = requests[file_requests.front()].path;
+	std::error_code size_error{};
+	const auto file_size = fs::file_size(path, size_error);
+
+	constexpr auto open_flags = static_cast<std::ios_base::openmode>(
+			static_cast<unsigned int>(std::ios::binary) | static_cast<unsigned int>(std::ios::in)
+	);
+	std::ifstream input;
+	if (!size_error)
+	{
+		input.open(path, open_flags);
+	}
+
+	for (const auto request_index : file_requests)
+	{
+		auto& result = results[request_index];
+		if (size_error)
+		{
+			result = std::unexpected(
+					std::format("Could not get size of file {}: {}.", path.string(), size_error.message())
+			);
+			continue;
+		}
+		const auto& request = requests[request_index];
+		const auto size_result = request_size(request, file_size);
+		if (!size_result.has_value())
+		{
+			result = std::unexpected(size_result.error());
+			continue;
+		}
+		if (!input.is_open())
+		{
+			result = std::unexpected(std::format("Could not open file {}.", path.string()));
+			continue;
+		}
+
+		auto& buffer = result.value();
+		buffer.resize(static_cast<buffer_t::size_type>(size_result.value()));
+		input.clear();
+		input.seekg(static_cast<std::ifstream::off_type>(request.offset));
+		input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		if (!input.good())
+		{
+			result = std::unexpected(std::format("Could not read file {}.", path.string()));
+		}
+	}
+}
+
+#if JOSK_IO_URING
+
+/** Number of operations that can be in flight at the same time. */
+constexpr unsigned int uring_queue_depth = 64U;
+/** Large requests are split in chunks of this size, allowing the device to serve them in parallel. */
+constexpr std::uint64_t uring_chunk_size = 1024U * 1024U;
+
+/** RAII wrapper around an io_uring instance. */
+class uring_t final
+{
+	io_uring _ring{};
+	bool _valid{};
+
+public:
+	explicit uring_t(const unsigned int entries)
+		: _valid{io_uring_queue_init(entries, &_ring, 0U) == 0}
+	{
+	}
+
+	uring_t(const uring_t&) = delete;
+	uring_t(uring_t&&) = delete;
+	uring_t& operator=(const uring_t&) = delete;
+	uring_t& operator=(uring_t&&) = delete;
+
+	~uring_t()
+	{
+		if (_valid)
+		{
+			io_uring_queue_exit(&_ring);
+		}
+	}
+
+	/** Kernels without io_uring support, or sandboxes blocking it, will fail to create the ring. */
+	[[nodiscard]] bool valid() const noexcept
+	{
+		return _valid;
+	}
+
+	[[nodiscard]] io_uring* get() noexcept
+	{
+		return &_ring;
+	}
+};
+
+/** Owning wrapper around a file descriptor. */
+class file_descriptor_t final
+{
+	int _descriptor{-1};
+
+public:
+	file_descriptor_t() = default;
+
+	file_descriptor_t(const file_descriptor_t&) = delete;
+	file_descriptor_t(file_descriptor_t&&) = delete;
+	file_descriptor_t& operator=(const file_descriptor_t&) = delete;
+	file_descriptor_t& operator=(file_descriptor_t&&) = delete;
+
+	~file_descriptor_t()
+	{
+		reset();
+	}
+
+	/**
+	 * Closes the current descriptor, if any, and takes ownership of another one.
+	 * @param descriptor New descriptor, or a negative value to leave the wrapper empty.
+	 */
+	void reset(const int descriptor = -1) noexcept
+	{
+		if (_descriptor >= 0)
+		{
+			::close(_descriptor);
+		}
+		_descriptor = descriptor;
+	}
+
+	[[nodiscard]] int get() const noexcept
+	{
+		return _descriptor;
+	}
+};
+
+/** File opened by the io_uring backend, shared by all of its requests. It is closed once all of its chunks complete. */
+struct uring_file_t final
+{
+	file_descriptor_t descriptor;
+	std::size_t remaining_chunks{};
+};
+
+/** Single read operation submitted to the ring. Short reads update the chunk and submit it again. */
+struct uring_chunk_t final
+{
+	std::size_t file_index;
+	std::size_t request_index;
+	int descriptor;
+	std::uint64_t file_offset;
+	char* destination;
+	unsigned int size;
+};
+
+/**
+ * Waits until every submitted operation of a ring has completed, discarding their results.
+ * @param ring Valid io_uring instance.
+ * @param submitted Operations submitted to the kernel which have not completed yet.
+ * @return False if the ring cannot be waited on anymore, and operations may still be in flight.
+ */
+bool drain_uring(uring_t& ring, unsigned int submitted)
+{
+	while (submitted > 0U)
+	{
+		io_uring_cqe* cqe{};
+		if (const int wait_result = io_uring_wait_cqe(ring.get(), &cqe); wait_result < 0)
+		{
+			if (wait_result == -EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		io_uring_cqe_seen(ring.get(), cqe);
+		--submitted;
+	}
+	return true;
+}
+
+/**
+ * Reads all requests using a single ring.
+ * @param requests File ranges to read.
+ * @param ring Valid io_uring instance.
+ * @return Read results, or nullopt if the ring failed and the portable backend must be used instead.
+ */
+std::optional<std::vector<read_result_t>> read_uring(const std::span<const read_request_t> requests, uring_t& ring)
+{
+	std::vector<read_result_t> results(requests.size());
+	std::vector<std::string> errors(requests.size());
+	const auto file_requests = group_by_file(requests);
+	std::vector<uring_file_t> files(file_requests.size());
+	std::vector<uring_chunk_t> chunks;
+
+	// Opens a file and splits the ranges of all of its requests in chunks. Failed requests get an error and no chunks.
+	const auto add_file = [&](const std::size_t file_index)
+	{
+		const auto& path = requests[file_requests[file_index].front()].path;
+		auto& file = files[file_index];
+		file.descriptor.reset(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+		std::string file_error{};
+		struct stat file_status{};
+		if (file.descriptor.get() < 0)
+		{
+			file_error = std::format("Could not open file {}.", path.string());
+		}
+		else if (::fstat(file.descriptor.get(), &file_status) != 0)
+		{
+			file_error = std::format(
+					"Could not get size of file {}: {}.", path.string(), std::system_category().message(errno)
+			);
+		}
+
+		for (const auto request_index : file_requests[file_index])
+		{
+			if (!file_error.empty())
+			{
+				errors[request_index] = file_error;
+				continue;
+			}
+			const auto& request = requests[request_index];
+			const auto size_result = request_size(request, static_cast<std::uint64_t>(file_status.st_size));
+			if (!size_result.has_value())
+			{
+				errors[request_index] = size_result.error();
+				continue;
+			}
+
+			auto& buffer = results[request_index].value();
+			buffer.resize(static_cast<buffer_t::size_type>(size_result.value()));
+			for (std::uint64_t chunk_offset{}; chunk_offset < buffer.size(); chunk_offset += uring_chunk_size)
+			{
+				const auto chunk_size = std::min(uring_chunk_size, buffer.size() - chunk_offset);
+				chunks.emplace_back(
+						file_index, request_index, file.descriptor.get(), request.offset + chunk_offset,
+						buffer.data() + chunk_offset, static_cast<unsigned int>(chunk_size)
+				);
+				++file.remaining_chunks;
+			}
+		}
+		if (file.remaining_chunks == 0U)
+		{
+			file.descriptor.reset();
+		}
+	};
+
+	// Files are only opened once the ring has room for their chunks, and closed once those complete. This keeps the
+	// amount of open descriptors bounded by the queue depth, regardless of the amount of requests.
+	std::size_t next_file{};
+	std::size_t next_chunk{};
+	// Chunks which completed with a short read, and must be submitted again for their remaining bytes.
+	std::vector<std::size_t> pending_chunks;
+	unsigned int in_flight{};
+	bool ring_failed{};
+	while (true)
+	{
+		while (in_flight < uring_queue_depth && io_uring_sq_space_left(ring.get()) > 0U)
+		{
+			std::size_t chunk_index{};
+			if (!pending_chunks.empty())
+			{
+				chunk_index = pending_chunks.back();
+				pending_chunks.pop_back();
+			}
+			else if (next_chunk < chunks.size())
+			{
+				chunk_index = next_chunk++;
+			}
+			else if (next_file < files.size())
+			{
+				add_file(next_file++);
+				continue;
+			}
+			else
+			{
+				break;
+			}
+
+			io_uring_sqe* sqe = io_uring_get_sqe(ring.get());
+			const auto& chunk = chunks[chunk_index];
+			io_uring_prep_read(sqe, chunk.descriptor, chunk.destination, chunk.size, chunk.file_offset);
+			io_uring_sqe_set_data64(sqe, chunk_index);
+			++in_flight;
+		}
+		if (in_flight == 0U)
+		{
+			break;
+		}
+
+		// Signals interrupt the wait, but submitted reads continue. Their completions are reaped as usual.
+		if (const int submit_result = io_uring_submit_and_wait(ring.get(), 1U);
+				submit_result < 0 && submit_result != -EINTR)
+		{
+			ring_failed = true;
+			break;
+		}
+
+		io_uring_cqe* cqe{};
+		unsigned int head{};
+		unsigned int completed{};
+		io_uring_for_each_cqe(ring.get(), head, cqe)
+		{
+			++completed;
+			const auto chunk_index = static_cast<std::size_t>(io_uring_cqe_get_data64(cqe));
+			auto& chunk = chunks[chunk_index];
+			auto& error = errors[chunk.request_index];
+			if (error.empty() && cqe->res < 0)
+			{
+				error = std::format(
+						"Could not read file {}: {}.", requests[chunk.request_index].path.string(),
+						std::system_category().message(-cqe->res)
+				);
+			}
+			else if (error.empty() && cqe->res == 0)
+			{
+				error = std::format("Unexpected end of file {}.", requests[chunk.request_index].path.string());
+			}
+			else if (error.empty() && static_cast<unsigned int>(cqe->res) < chunk.size)
+			{
+				const auto read_size = static_cast<unsigned int>(cqe->res);
+				chunk.file_offset += read_size;
+				chunk.destination += read_size;
+				chunk.size -= read_size;
+				pending_chunks.push_back(chunk_index);
+				continue;
+			}
+
+			if (auto& file = files[chunk.file_index]; --file.remaining_chunks == 0U)
+			{
+				file.descriptor.reset();
+			}
+		}
+		io_uring_cq_advance(ring.get(), completed);
+		in_flight -= completed;
+	}
+
+	// Reads submitted before a ring failure keep writing into the result buffers, so they must complete first.
+	if (ring_failed && !drain_uring(ring, in_flight - io_uring_sq_ready(ring.get())))
+	{
+		// The kernel may still write into the buffers, so no memory can be released safely anymore.
+		std::abort();
+	}
+	if (ring_failed)
+	{
+		return std::nullopt;
+	}
+
+	for (std::size_t request_index{}; request_index < requests.size(); ++request_index)
+	{
+		if (!errors[request_index].empty())
+		{
+			results[request_index] = std::unexpected(std::move(errors[request_index]));
+		}
+	}
+	return results;
+}
+
+#endif
+
+}
+
+namespace josk::io
+{
+
+backend_t available_backend() noexcept
+{
+#if JOSK_IO_URING
+	static const bool uring_available = uring_t{1U}.valid();
+	if (uring_available)
+	{
+		return backend_t::io_uring;
+	}
+#endif
+	return backend_t::portable;
+}
+
+std::vector<read_result_t> read(const std::span<const read_request_t> requests, const backend_t backend)
+{
+#if JOSK_IO_URING
+	if (backend == backend_t::io_uring)
+	{
+		if (uring_t ring{uring_queue_depth}; ring.valid())
+		{
+			if (auto results = read_uring(requests, ring); results.has_value())
+			{
+				return std::move(results.value());
+			}
+		}
+	}
+#else
+	static_cast<void>(backend);
+#endif
+
+	std::vector<read_result_t> results(requests.size());
+	for (const auto& file_requests : group_by_file(requests))
+	{
+		read_portable(requests, file_requests, results);
+	}
+	return results;
+}
+
+std::expected<void, std::string> decompress(
+		const std::span<const char> compressed_data, const std::span<char> destination
+)
+{
+	auto destination_size = static_cast<uLongf>(destination.size());
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	const int result = ::uncompress(
+			reinterpret_cast<Bytef*>(destination.data()), &destination_size,
+			reinterpret_cast<const Bytef*>(compressed_data.data()), static_cast<uLong>(compressed_data.size())
+	);
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	if (result != Z_OK)
+	{
+		return std::unexpected(::zError(result));
+	}
+	if (destination_size != destination.size())
+	{
+		return std::unexpected(
+				std::format("{} bytes were decompressed instead of {}", destination_size, destination.size())
+		);
+	}
+	return {};
+}
+
+std::uint64_t hash_bytes(const std::span<const char> data, const std::uint64_t seed) noexcept
+{
+	// MurmurHash64A. Data is consumed eight bytes at a time.
+	constexpr std::uint64_t multiplier = 0xC6A4A7935BD1E995U;
+	constexpr unsigned shift = 47U;
+	const auto mix = [](std::uint64_t value)
+	{
+		value *= multiplier;
+		value ^= value >> shift;
+		return value * multiplier;
+	};
+
+	std::uint64_t hash = seed ^ (data.size() * multiplier);
+	constexpr auto block_size = sizeof(std::uint64_t);
+	const auto block_end = data.size() - (data.size() % block_size);
+	for (std::size_t offset{}; offset < block_end; offset += block_size)
+	{
+		std::uint64_t block{};
+		std::memcpy(&block, data.data() + offset, block_size);
+		hash = (hash ^ mix(block)) * multiplier;
+	}
+	if (const auto tail = data.subspan(block_end); !tail.empty())
+	{
+		std::uint64_t block{};
+		std::memcpy(&block, tail.data(), tail.size());
+		hash = (hash ^ block) * multiplier;
+	}
+
+	hash ^= hash >> shift;
+	hash *= multiplier;
+	return hash ^ (hash >> shift);
+}
+
+}
@@ -1,13 +1,20 @@
 #include <josk/cli.hpp>
+#include <josk/daemon.hpp>
+#include <josk/stats.hpp>
 #include <josk/tasks.hpp>
+#include <josk/tes_parse.hpp>
+#include <josk/trace.hpp>
 
 #include <CLI/App.hpp>
 
 #include <cstdio>
 #include <cstdlib>
 #include <expected>
+#include <filesystem>
 #include <print>
+#include <string>
 #include <utility>
+#include <vector>
 
 int main(const int argc, char* argv[])
 {
@@ -16,10 +23,84 @@ int main(const int argc, char* argv[])
 	josk::cli::configure_cli(app, arguments);
 	CLI11_PARSE(app, argc, argv);
 
+	const auto output_path = arguments.output_path;
+	const auto stats_format = arguments.stats_format;
+	const auto trace_path = arguments.trace_path;
+	const auto record_types = arguments.record_types;
+	const auto lazy_decode = arguments.lazy_decode;
+	const auto override_report = arguments.override_report;
+	if (!trace_path.empty())
+	{
+		josk::trace::start();
+	}
+
+	const auto extract =
+			[record_types, lazy_decode, override_report, &output_path](josk::cli::arguments_t validated_arguments)
+	{
+		return josk::task::parse_load_order(std::move(validated_arguments))
+				.and_then(josk::task::find_plugins)
+				.and_then(
+						[record_types, lazy_decode, override_report](const std::vector<josk::task::plugin_t>& plugins)
+								-> std::expected<josk::task::extracted_data_t, std::string>
+						{
+							if (lazy_decode)
+							{
+								auto index = josk::task::index_plugins(plugins, record_types);
+								if (!index.has_value())
+								{
+									return std::unexpected(std::move(index.error()));
+								}
+								auto data = josk::task::materialize_index(index.value()).transform(josk::task::derive_data);
+								if (!override_report || !data.has_value())
+								{
+									return data;
+								}
+								// The index built to materialize the records already holds every version of each record.
+								return josk::task::add_override_report(std::move(data.value()), std::move(index.value()));
+							}
+							auto data = josk::task::parse_plugins(plugins, record_types).transform(josk::task::derive_data);
+							if (!override_report || !data.has_value())
+							{
+								return data;
+							}
+							return josk::task::add_override_report(std::move(data.value()), plugins, record_types);
+						}
+				)
+				.and_then([&output_path](const josk::task::extracted_data_t& data)
+									{ return josk::task::write_output(data, output_path); });
+	};
 	const auto tasks_result = josk::cli::validate_arguments(std::move(arguments))
-																.and_then(josk::task::parse_load_order)
-																.and_then(josk::task::find_plugins)
-																.and_then(josk::task::parse_plugins);
+																.and_then(
+																		[&extract](josk::cli::arguments_t validated_arguments)
+																		{
+																			if (validated_arguments.daemon.enabled)
+																			{
+																				return josk::daemon::run(std::move(validated_arguments));
+																			}
+																			if (!validated_arguments.batch_profile_paths.empty())
+																			{
+																				return josk::task::extract_profiles(std::move(validated_arguments));
+																			}
+																			return validated_arguments.diff.enabled
+																										 ? josk::task::diff_modlists(std::move(validated_arguments))
+																										 : extract(std::move(validated_arguments));
+																		}
+																);
+
+	if constexpr (josk::stats::enabled)
+	{
+		if (stats_format != josk::stats::format_t::none)
+		{
+			std::print("{}", josk::stats::format_report(josk::stats::report(), stats_format));
+		}
+		if (!trace_path.empty())
+		{
+			if (const auto trace_result = josk::trace::write(trace_path); !trace_result.has_value())
+			{
+				std::println(stderr, "{}", trace_result.error());
+			}
+		}
+	}
 
 	if (!tasks_result.has_value())
 	{
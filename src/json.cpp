@@ -0,0 +1,258 @@
+#include <josk/json.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+/** Encoding of a character as UTF-8. */
+struct utf8_character_t final
+{
+	std::array<char, 3Z> bytes{};
+	std::size_t size{};
+};
+
+/** Encodes a code point of the Basic Multilingual Plane as UTF-8. */
+constexpr utf8_character_t to_utf8(const char32_t code_point) noexcept
+{
+	if (code_point < 0x800U)
+	{
+		return {
+				.bytes = {static_cast<char>(0xC0U | (code_point >> 6U)), static_cast<char>(0x80U | (code_point & 0x3FU)), '\0'},
+				.size = 2Z,
+		};
+	}
+	return {
+			.bytes =
+					{
+							static_cast<char>(0xE0U | (code_point >> 12U)),
+							static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU)),
+							static_cast<char>(0x80U | (code_point & 0x3FU)),
+					},
+			.size = 3Z,
+	};
+}
+
+/**
+ * UTF-8 encoding of each non-ASCII character of the Windows-1252 code page. Bytes left undefined by the code page are
+ * mapped to the C1 control character with the same value, like Windows does.
+ */
+constexpr auto windows_1252_table = []
+{
+	constexpr std::array<char32_t, 32Z> c1_replacements{
+			0x20ACU, 0x0081U, 0x201AU, 0x0192U, 0x201EU, 0x2026U, 0x2020U, 0x2021U, 0x02C6U, 0x2030U, 0x0160U,
+			0x2039U, 0x0152U, 0x008DU, 0x017DU, 0x008FU, 0x0090U, 0x2018U, 0x2019U, 0x201CU, 0x201DU, 0x2022U,
+			0x2013U, 0x2014U, 0x02DCU, 0x2122U, 0x0161U, 0x203AU, 0x0153U, 0x009DU, 0x017EU, 0x0178U,
+	};
+	std::array<utf8_character_t, 128Z> table{};
+	for (std::size_t index{}; index < table.size(); ++index)
+	{
+		const auto code_point =
+				index < c1_replacements.size() ? c1_replacements[index] : static_cast<char32_t>(0x80U + index);
+		table[index] = to_utf8(code_point);
+	}
+	return table;
+}();
+
+/**
+ * Size of the UTF-8 sequence starting a string.
+ * @param value String starting with a non-ASCII byte.
+ * @return Size of the sequence, or zero if it is not valid UTF-8.
+ */
+constexpr std::size_t utf8_sequence_size(const std::string_view value) noexcept
+{
+	const auto byte = [&value](const std::size_t position) { return static_cast<unsigned char>(value[position]); };
+	const auto lead = byte(0Z);
+	std::size_t size{};
+	// Range of the second byte, which also rejects overlong encodings, surrogates and values above U+10FFFF.
+	unsigned char second_min{0x80U};
+	unsigned char second_max{0xBFU};
+	if (lead >= 0xC2U && lead <= 0xDFU)
+	{
+		size = 2Z;
+	}
+	else if (lead >= 0xE0U && lead <= 0xEFU)
+	{
+		size = 3Z;
+		second_min = lead == 0xE0U ? 0xA0U : second_min;
+		second_max = lead == 0xEDU ? 0x9FU : second_max;
+	}
+	else if (lead >= 0xF0U && lead <= 0xF4U)
+	{
+		size = 4Z;
+		second_min = lead == 0xF0U ? 0x90U : second_min;
+		second_max = lead == 0xF4U ? 0x8FU : second_max;
+	}
+	if (size == 0Z || value.size() < size || byte(1Z) < second_min || byte(1Z) > second_max)
+	{
+		return 0Z;
+	}
+	for (std::size_t position{2Z}; position < size; ++position)
+	{
+		if ((byte(position) & 0xC0U) != 0x80U)
+		{
+			return 0Z;
+		}
+	}
+	return size;
+}
+
+constexpr bool needs_processing(const char character) noexcept
+{
+	const auto code = static_cast<unsigned char>(character);
+	return code < 0x20U || code >= 0x80U || character == '"' || character == '\\';
+}
+
+/**
+ * Finds the first character which cannot be copied as is into a JSON string. Data is checked eight bytes at a time,
+ * as most names and descriptions are plain ASCII text.
+ * @param value String to check.
+ * @return Position of the first non-ASCII, control, quote or backslash character, or the size of the string.
+ */
+std::size_t plain_ascii_prefix(const std::string_view value) noexcept
+{
+	constexpr std::uint64_t ones = 0x0101010101010101U;
+	constexpr std::uint64_t high_bits = 0x8080808080808080U;
+	// Nonzero if any byte of the block is zero, or lower than the byte value multiplied by ones.
+	const auto has_zero_byte = [](const std::uint64_t block) { return (block - ones) & ~block & high_bits; };
+	const auto has_byte_below = [](const std::uint64_t block, const std::uint64_t limit)
+	{ return (block - limit) & ~block & high_bits; };
+
+	constexpr auto block_size = sizeof(std::uint64_t);
+	std::size_t offset{};
+	for (; offset + block_size <= value.size(); offset += block_size)
+	{
+		std::uint64_t block{};
+		std::memcpy(&block, value.data() + offset, block_size);
+		const auto special_bytes = (block & high_bits) | has_byte_below(block, ones * 0x20U) |
+															 has_zero_byte(block ^ (ones * std::uint64_t{'"'})) |
+															 has_zero_byte(block ^ (ones * std::uint64_t{'\\'}));
+		if (special_bytes != 0U)
+		{
+			break;
+		}
+	}
+	while (offset < value.size() && !needs_processing(value[offset]))
+	{
+		++offset;
+	}
+	return offset;
+}
+
+/**
+ * Checks if a string is encoded as UTF-8.
+ * @param value String to check.
+ * @return True if every non-ASCII character is a valid UTF-8 sequence.
+ */
+bool is_utf8(std::string_view value) noexcept
+{
+	while (!value.empty())
+	{
+		if (static_cast<unsigned char>(value.front()) < 0x80U)
+		{
+			value.remove_prefix(1Z);
+			continue;
+		}
+		const auto size = utf8_sequence_size(value);
+		if (size == 0Z)
+		{
+			return false;
+		}
+		value.remove_prefix(size);
+	}
+	return true;
+}
+
+void append_escaped(std::string& output, const char character)
+{
+	constexpr std::array<char, 16Z> hex_digits{
+			'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+	};
+	switch (character)
+	{
+		case '"':
+			output.append("\\\"");
+			break;
+		case '\\':
+			output.append("\\\\");
+			break;
+		case '\n':
+			output.append("\\n");
+			break;
+		case '\r':
+			output.append("\\r");
+			break;
+		case '\t':
+			output.append("\\t");
+			break;
+		default:
+		{
+			const auto code = static_cast<unsigned char>(character);
+			output.append("\\u00");
+			output.push_back(hex_digits[code >> 4U]);
+			output.push_back(hex_digits[code & 0xFU]);
+			break;
+		}
+	}
+}
+
+}
+
+namespace josk::json
+{
+
+void append_string(std::string& output, std::string_view value)
+{
+	// TES string fields keep the null terminator of the original data.
+	while (!value.empty() && value.back() == '\0')
+	{
+		value.remove_suffix(1Z);
+	}
+
+	output.push_back('"');
+	// The encoding is only checked once a non-ASCII character is found.
+	std::optional<bool> utf8;
+	while (!value.empty())
+	{
+		const auto plain_size = plain_ascii_prefix(value);
+		output.append(value.data(), plain_size);
+		value.remove_prefix(plain_size);
+		if (value.empty())
+		{
+			break;
+		}
+
+		const auto code = static_cast<unsigned char>(value.front());
+		if (code < 0x80U)
+		{
+			append_escaped(output, value.front());
+			value.remove_prefix(1Z);
+			continue;
+		}
+		if (!utf8.has_value())
+		{
+			utf8 = is_utf8(value);
+		}
+		if (utf8.value())
+		{
+			const auto size = utf8_sequence_size(value);
+			output.append(value.data(), size);
+			value.remove_prefix(size);
+		}
+		else
+		{
+			const auto& character = windows_1252_table[code - 0x80U];
+			output.append(character.bytes.data(), character.size);
+			value.remove_prefix(1Z);
+		}
+	}
+	output.push_back('"');
+}
+
+}
@@ -0,0 +1,145 @@
+#include <josk/memory_stats.hpp>
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+// windows.h must be included before psapi.h.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if JOSK_MEMORY_STATS
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<std::uint64_t> allocation_count{};
+std::atomic<std::uint64_t> allocated_byte_count{};
+
+void count_allocation(const std::size_t size) noexcept
+{
+	// Relaxed ordering is enough, as counters are only read after the work being measured has finished.
+	allocation_count.fetch_add(1U, std::memory_order_relaxed);
+	allocated_byte_count.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* allocate(const std::size_t size)
+{
+	count_allocation(size);
+	// malloc(0) may return a null pointer, but operator new must return a unique pointer.
+	if (void* pointer = std::malloc(size == 0Z ? 1Z : size); pointer != nullptr)
+	{
+		return pointer;
+	}
+	throw std::bad_alloc{};
+}
+
+void* allocate_aligned(const std::size_t size, const std::align_val_t alignment)
+{
+	count_allocation(size);
+	const auto alignment_size = static_cast<std::size_t>(alignment);
+#if defined(_WIN32)
+	void* pointer = _aligned_malloc(size == 0Z ? 1Z : size, alignment_size);
+#else
+	// aligned_alloc requires the size to be a multiple of the alignment.
+	const auto aligned_size = ((size + alignment_size - 1Z) / alignment_size) * alignment_size;
+	void* pointer = std::aligned_alloc(alignment_size, aligned_size == 0Z ? alignment_size : aligned_size);
+#endif
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc{};
+	}
+	return pointer;
+}
+
+void deallocate_aligned(void* pointer) noexcept
+{
+#if defined(_WIN32)
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+}
+
+// Replacements of the global allocation functions. Array and nothrow versions forward to these by default.
+
+void* operator new(const std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /*size*/) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::align_val_t /*alignment*/) noexcept
+{
+	deallocate_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /*size*/, const std::align_val_t /*alignment*/) noexcept
+{
+	deallocate_aligned(pointer);
+}
+#endif
+
+namespace josk::memory
+{
+
+allocation_counters_t allocation_counters() noexcept
+{
+#if JOSK_MEMORY_STATS
+	return {
+			.allocations = allocation_count.load(std::memory_order_relaxed),
+			.allocated_bytes = allocated_byte_count.load(std::memory_order_relaxed),
+	};
+#else
+	return {};
+#endif
+}
+
+std::uint64_t peak_resident_bytes() noexcept
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == 0)
+	{
+		return 0U;
+	}
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0U;
+	}
+#if defined(__APPLE__)
+	// macOS reports ru_maxrss in bytes.
+	return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+	// Linux and BSD report ru_maxrss in kibibytes.
+	return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024U;
+#endif
+#endif
+}
+
+}
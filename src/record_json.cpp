@@ -0,0 +1,241 @@
+#include <josk/json.hpp>
+#include <josk/record_json.hpp>
+#include <josk/tes_format.hpp>
+
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+constexpr std::string_view to_category_string(const josk::tes::skill_category_t category) noexcept
+{
+	switch (category)
+	{
+		case josk::tes::skill_category_t::other:
+			return "other";
+		case josk::tes::skill_category_t::combat:
+			return "combat";
+		case josk::tes::skill_category_t::magic:
+			return "magic";
+		case josk::tes::skill_category_t::stealth:
+			return "stealth";
+	}
+	return "other";
+}
+
+constexpr std::string_view to_compare_string(const josk::tes::compare_op_t op) noexcept
+{
+	switch (op)
+	{
+		case josk::tes::compare_op_t::equal:
+			return "==";
+		case josk::tes::compare_op_t::not_equal:
+			return "!=";
+		case josk::tes::compare_op_t::greater:
+			return ">";
+		case josk::tes::compare_op_t::greater_equal:
+			return ">=";
+		case josk::tes::compare_op_t::less:
+			return "<";
+		case josk::tes::compare_op_t::less_equal:
+			return "<=";
+	}
+	return "==";
+}
+
+constexpr std::string_view to_run_on_string(const josk::tes::condition_run_on_t run_on) noexcept
+{
+	switch (run_on)
+	{
+		case josk::tes::condition_run_on_t::subject:
+			return "subject";
+		case josk::tes::condition_run_on_t::target:
+			return "target";
+		case josk::tes::condition_run_on_t::reference:
+			return "reference";
+		case josk::tes::condition_run_on_t::combat_target:
+			return "combat_target";
+		case josk::tes::condition_run_on_t::linked_reference:
+			return "linked_reference";
+		case josk::tes::condition_run_on_t::quest_alias:
+			return "quest_alias";
+		case josk::tes::condition_run_on_t::package_data:
+			return "package_data";
+		case josk::tes::condition_run_on_t::event_data:
+			return "event_data";
+	}
+	return "subject";
+}
+
+void append_conditions(std::string& output, const josk::tes::condition_program_t& program)
+{
+	auto out = std::back_inserter(output);
+	const auto append_string_parameter = [&output, &program](const std::string_view key, const std::uint16_t string_index)
+	{
+		if (string_index != josk::tes::no_condition_string)
+		{
+			std::format_to(std::back_inserter(output), ",\"{}\":", key);
+			josk::json::append_string(output, program.strings[string_index]);
+		}
+	};
+
+	output.push_back('[');
+	for (bool first{true}; const auto& condition : program.conditions)
+	{
+		std::format_to(
+				out, "{}{{\"function\":{},\"run_on\":\"{}\",\"op\":\"{}\",", first ? "" : ",",
+				static_cast<std::uint16_t>(condition.function), to_run_on_string(condition.run_on),
+				to_compare_string(condition.op)
+		);
+		if ((condition.flags & josk::tes::condition_use_global_flag) != 0U)
+		{
+			std::format_to(out, "\"global_id\":{}", std::bit_cast<josk::tes::formid_t>(condition.value));
+		}
+		else
+		{
+			std::format_to(out, "\"value\":{}", condition.value);
+		}
+		std::format_to(
+				out, ",\"param1\":{},\"param2\":{},\"or\":{}", condition.param1, condition.param2,
+				(condition.flags & josk::tes::condition_or_flag) != 0U
+		);
+		append_string_parameter("string1", condition.string1);
+		append_string_parameter("string2", condition.string2);
+		output.push_back('}');
+		first = false;
+	}
+	output.push_back(']');
+}
+
+void append_formid(std::string& output, const josk::tes::formid_t formid)
+{
+	if (formid == josk::tes::invalid_formid)
+	{
+		output.append("null");
+	}
+	else
+	{
+		std::format_to(std::back_inserter(output), "{}", formid);
+	}
+}
+
+}
+
+namespace josk::json
+{
+
+void append_record_fields(std::string& output, const tes::avif_record& record)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(out, "\"record_id\":{},\"name\":", record.record_id);
+	append_string(output, record.name);
+	output.append(",\"description\":");
+	append_string(output, record.description);
+	std::format_to(out, ",\"category\":\"{}\",\"perks\":[", to_category_string(record.category));
+	for (bool first{true}; const auto& [perk_id, x_pos, y_pos] : record.perks)
+	{
+		std::format_to(out, "{}{{\"record_id\":{},\"x\":{},\"y\":{}}}", first ? "" : ",", perk_id, x_pos, y_pos);
+		first = false;
+	}
+	output.push_back(']');
+}
+
+void append_record_fields(std::string& output, const tes::perk_record& record)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(out, "\"record_id\":{},\"name\":", record.record_id);
+	append_string(output, record.name);
+	output.append(",\"description\":");
+	append_string(output, record.description);
+	std::format_to(out, ",\"skill_req\":{},\"prereq_perk_ids\":[", record.skill_req);
+	for (bool first{true}; const auto prereq_id : record.prereq_perk_ids)
+	{
+		std::format_to(out, "{}{}", first ? "" : ",", prereq_id);
+		first = false;
+	}
+	output.append("],\"conditions\":");
+	append_conditions(output, record.conditions);
+	output.append(",\"next_perk_id\":");
+	append_formid(output, record.next_perk_id);
+}
+
+void append_record_fields(std::string& output, const tes::leveled_list_record& record)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(
+			out, "\"record_id\":{},\"type\":\"{}\",\"chance_none\":{},\"flags\":{},\"chance_none_global\":",
+			record.record_id, tes::to_record_string(record.record_type), record.chance_none, record.flags
+	);
+	append_formid(output, record.chance_none_global);
+	output.append(",\"entries\":[");
+	for (bool first{true}; const auto& [level, record_id, count] : record.entries)
+	{
+		std::format_to(out, "{}{{\"level\":{},\"record_id\":{},\"count\":{}}}", first ? "" : ",", level, record_id, count);
+		first = false;
+	}
+	output.push_back(']');
+}
+
+void append_record_fields(std::string& output, const tes::cobj_record& record)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(out, "\"record_id\":{},\"created_object_id\":", record.record_id);
+	append_formid(output, record.created_object_id);
+	output.append(",\"workbench_keyword_id\":");
+	append_formid(output, record.workbench_keyword_id);
+	std::format_to(out, ",\"created_count\":{},\"components\":[", record.created_count);
+	for (bool first{true}; const auto& [record_id, count] : record.components)
+	{
+		std::format_to(out, "{}{{\"record_id\":{},\"count\":{}}}", first ? "" : ",", record_id, count);
+		first = false;
+	}
+	output.append("],\"conditions\":");
+	append_conditions(output, record.conditions);
+}
+
+void append_record_fields(std::string& output, const tes::placed_reference& record)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(
+			out, "\"record_id\":{},\"type\":\"{}\",\"base_id\":{},\"world_id\":", record.record_id,
+			tes::to_record_string(record.record_type), record.base_id
+	);
+	append_formid(output, record.world_id);
+	const auto& [x_pos, y_pos, z_pos] = record.position;
+	std::format_to(out, ",\"cell_id\":{},\"x\":{},\"y\":{},\"z\":{}", record.cell_id, x_pos, y_pos, z_pos);
+}
+
+void append_record_fields(std::string& output, const tes::dial_record& record)
+{
+	std::format_to(std::back_inserter(output), "\"record_id\":{},\"name\":", record.record_id);
+	append_string(output, record.name);
+	output.append(",\"quest_id\":");
+	append_formid(output, record.quest_id);
+	std::format_to(std::back_inserter(output), ",\"category\":{},\"subtype\":{}", record.category, record.subtype);
+}
+
+void append_record_fields(std::string& output, const tes::info_record& record)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(out, "\"record_id\":{},\"topic_id\":{},\"previous_info_id\":", record.record_id, record.topic_id);
+	append_formid(output, record.previous_info_id);
+	output.append(",\"prompt\":");
+	append_string(output, record.prompt);
+	output.append(",\"responses\":[");
+	for (bool first{true}; const auto& [response_number, text] : record.responses)
+	{
+		std::format_to(out, "{}{{\"response_number\":{},\"text\":", first ? "" : ",", response_number);
+		append_string(output, text);
+		output.push_back('}');
+		first = false;
+	}
+	output.append("],\"conditions\":");
+	append_conditions(output, record.conditions);
+}
+
+}
@@ -0,0 +1,320 @@
+#include <josk/arena.hpp>
+#include <josk/cli.hpp>
+#include <josk/session.hpp>
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using josk::session::file_state_t;
+using josk::session::loaded_plugin_t;
+using josk::session::record_location_t;
+
+file_state_t read_file_state(const std::filesystem::path& path)
+{
+	// Files which cannot be checked are always parsed again, and parsing reports the error.
+	std::error_code error;
+	file_state_t file{.size = std::filesystem::file_size(path, error), .write_time = {}};
+	file.write_time = std::filesystem::last_write_time(path, error);
+	return file;
+}
+
+template <typename Record>
+void add_locations(
+		loaded_plugin_t& plugin, const std::vector<Record>& records, const josk::tes::record_type_t record_type
+)
+{
+	for (std::size_t position{}; position < records.size(); ++position)
+	{
+		const auto& record = records[position];
+		if constexpr (requires { record.record_type; })
+		{
+			plugin.locations.emplace(record.record_id, record_location_t{record.record_type, position});
+		}
+		else
+		{
+			plugin.locations.emplace(record.record_id, record_location_t{record_type, position});
+		}
+	}
+}
+
+/**
+ * Creates a loaded plugin from its parsed records.
+ * @param plugin Plugin.
+ * @param file State of the plugin file when it was parsed.
+ * @param records Every record of the plugin.
+ * @return Loaded plugin.
+ */
+std::unique_ptr<loaded_plugin_t> load_plugin(
+		josk::task::plugin_t plugin, const file_state_t file, josk::tes::parsed_records_t records
+)
+{
+	using josk::tes::record_type_t;
+	auto loaded = std::make_unique<loaded_plugin_t>(std::move(plugin), file, std::move(records));
+	const auto& loaded_records = loaded->records;
+	add_locations(*loaded, loaded_records.avif_records, record_type_t::avif);
+	add_locations(*loaded, loaded_records.perk_records, record_type_t::perk);
+	add_locations(*loaded, loaded_records.leveled_list_records, record_type_t::none);
+	add_locations(*loaded, loaded_records.cobj_records, record_type_t::cobj);
+	add_locations(*loaded, loaded_records.placed_references, record_type_t::none);
+	add_locations(*loaded, loaded_records.dial_records, record_type_t::dial);
+	add_locations(*loaded, loaded_records.info_records, record_type_t::info);
+	return loaded;
+}
+
+/** Vector of parsed records storing records of a specific type. */
+template <typename Record>
+std::vector<Record>& records_of(josk::tes::parsed_records_t& records) noexcept
+{
+	if constexpr (std::is_same_v<Record, josk::tes::avif_record>)
+	{
+		return records.avif_records;
+	}
+	else if constexpr (std::is_same_v<Record, josk::tes::perk_record>)
+	{
+		return records.perk_records;
+	}
+	else if constexpr (std::is_same_v<Record, josk::tes::leveled_list_record>)
+	{
+		return records.leveled_list_records;
+	}
+	else if constexpr (std::is_same_v<Record, josk::tes::cobj_record>)
+	{
+		return records.cobj_records;
+	}
+	else if constexpr (std::is_same_v<Record, josk::tes::placed_reference>)
+	{
+		return records.placed_references;
+	}
+	else if constexpr (std::is_same_v<Record, josk::tes::dial_record>)
+	{
+		return records.dial_records;
+	}
+	else
+	{
+		static_assert(std::is_same_v<Record, josk::tes::info_record>);
+		return records.info_records;
+	}
+}
+
+}
+
+namespace josk::session
+{
+
+session_t::session_t(cli::arguments_t arguments)
+	: _arguments{std::move(arguments)}
+	, _arena_count{std::max<std::size_t>(std::thread::hardware_concurrency(), 1Z)}
+{
+	_arenas = std::make_unique<memory::arena_t[]>(_arena_count);
+}
+
+void session_t::update_winner(const tes::formid_t record_id)
+{
+	const loaded_plugin_t* winner{};
+	if (const auto itr = _versions.find(record_id); itr != _versions.cend())
+	{
+		for (const auto* plugin : itr->second)
+		{
+			if (winner == nullptr || plugin->plugin.order > winner->plugin.order)
+			{
+				winner = plugin;
+			}
+		}
+		if (itr->second.empty())
+		{
+			_versions.erase(itr);
+		}
+	}
+
+	if (const auto itr = _winners.find(record_id); itr != _winners.cend())
+	{
+		_type_winners[itr->second.location.record_type].erase(record_id);
+		_winners.erase(itr);
+	}
+	if (winner != nullptr)
+	{
+		const auto location = winner->locations.at(record_id);
+		_winners.emplace(record_id, record_version_t{winner, location});
+		_type_winners[location.record_type].emplace(record_id);
+	}
+}
+
+std::expected<refresh_summary_t, std::string> session_t::refresh()
+{
+	const stats::stage_timer timer{"refresh_session"};
+	const auto plugins = task::parse_load_order(_arguments).and_then(task::find_plugins);
+	if (!plugins.has_value())
+	{
+		return std::unexpected(plugins.error());
+	}
+
+	refresh_summary_t summary{};
+	std::unordered_set<std::string_view> current_plugins;
+	std::unordered_set<std::string_view> changed_filenames;
+	std::vector<task::plugin_t> changed_plugins;
+	std::vector<file_state_t> changed_files;
+	for (const auto& plugin : plugins.value())
+	{
+		current_plugins.emplace(plugin.filename);
+		const auto file = read_file_state(plugin.path);
+		if (const auto itr = _plugins.find(plugin.filename);
+				itr != _plugins.cend() && itr->second->plugin.path == plugin.path && itr->second->file == file)
+		{
+			summary.load_order_changed |= itr->second->plugin.order != plugin.order;
+			continue;
+		}
+		changed_filenames.emplace(plugin.filename);
+		changed_plugins.emplace_back(plugin);
+		changed_files.emplace_back(file);
+	}
+
+	// The session is only modified after every changed plugin has been parsed successfully.
+	auto parsed_plugins = task::parse_plugins_separately(
+			changed_plugins, _arguments.record_types, std::span{_arenas.get(), _arena_count}
+	);
+	if (!parsed_plugins.has_value())
+	{
+		return std::unexpected(std::move(parsed_plugins.error()));
+	}
+	summary.parsed_plugins = changed_plugins.size();
+
+	std::unordered_set<tes::formid_t> affected_records;
+	const auto unload_plugin = [this, &affected_records](const loaded_plugin_t& plugin)
+	{
+		for (const auto& [record_id, location] : plugin.locations)
+		{
+			std::erase(_versions[record_id], &plugin);
+			affected_records.emplace(record_id);
+		}
+	};
+	// Winners keep the location of their records, so plugins can be released before finding the new winners.
+	for (auto itr = _plugins.begin(); itr != _plugins.end();)
+	{
+		const auto& plugin = *itr->second;
+		const bool removed = !current_plugins.contains(plugin.plugin.filename);
+		const bool changed = changed_filenames.contains(plugin.plugin.filename);
+		if (!removed && !changed)
+		{
+			++itr;
+			continue;
+		}
+		summary.removed_plugins += removed ? 1Z : 0Z;
+		unload_plugin(plugin);
+		itr = _plugins.erase(itr);
+	}
+
+	for (const auto& plugin : plugins.value())
+	{
+		if (const auto itr = _plugins.find(plugin.filename); itr != _plugins.cend())
+		{
+			itr->second->plugin.order = plugin.order;
+		}
+	}
+	for (std::size_t index{}; index < changed_plugins.size(); ++index)
+	{
+		auto loaded = load_plugin(
+				std::move(changed_plugins[index]), changed_files[index], std::move(parsed_plugins.value()[index])
+		);
+		for (const auto& [record_id, location] : loaded->locations)
+		{
+			_versions[record_id].emplace_back(loaded.get());
+			affected_records.emplace(record_id);
+		}
+		const auto filename = loaded->plugin.filename;
+		_plugins.insert_or_assign(filename, std::move(loaded));
+	}
+
+	if (summary.load_order_changed)
+	{
+		_winners.clear();
+		_type_winners.clear();
+		std::vector<tes::formid_t> record_ids;
+		record_ids.reserve(_versions.size());
+		std::ranges::copy(_versions | std::views::keys, std::back_inserter(record_ids));
+		for (const auto record_id : record_ids)
+		{
+			update_winner(record_id);
+		}
+		summary.updated_records = record_ids.size();
+	}
+	else
+	{
+		for (const auto record_id : affected_records)
+		{
+			update_winner(record_id);
+		}
+		summary.updated_records = affected_records.size();
+	}
+
+	if constexpr (stats::enabled)
+	{
+		stats::add_container({"session_winners", _winners.size(), _winners.size() * sizeof(record_version_t)});
+	}
+	return summary;
+}
+
+std::expected<task::extracted_data_t, std::string> session_t::extract()
+{
+	return refresh().transform([this](const refresh_summary_t& /*summary*/)
+														 { return task::derive_data(winning_records()); });
+}
+
+const record_version_t* session_t::find_winner(const tes::formid_t record_id) const noexcept
+{
+	const auto itr = _winners.find(record_id);
+	return itr == _winners.cend() ? nullptr : &itr->second;
+}
+
+std::vector<tes::formid_t> session_t::record_ids(const tes::record_type_t record_type) const
+{
+	const auto itr = _type_winners.find(record_type);
+	if (itr == _type_winners.cend())
+	{
+		return {};
+	}
+	return {itr->second.cbegin(), itr->second.cend()};
+}
+
+tes::parsed_records_t session_t::winning_records() const
+{
+	const stats::stage_timer timer{"winning_records"};
+	std::vector<tes::formid_t> record_ids;
+	record_ids.reserve(_winners.size());
+	std::ranges::copy(_winners | std::views::keys, std::back_inserter(record_ids));
+	std::ranges::sort(record_ids);
+
+	tes::parsed_records_t records{};
+	for (const auto record_id : record_ids)
+	{
+		const auto& winner = _winners.at(record_id);
+		visit_record(
+				winner.plugin->records, winner.location,
+				[&records]<typename Record>(const Record& record) { records_of<Record>(records).emplace_back(record); }
+		);
+		records.parsed_record_ids.emplace(record_id);
+	}
+	return records;
+}
+
+}
@@ -0,0 +1,189 @@
+#include <josk/json.hpp>
+#include <josk/memory_stats.hpp>
+#include <josk/stats.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using josk::stats::steady_clock_t;
+
+struct collector_t final
+{
+	std::mutex mutex;
+	josk::stats::report_t report;
+};
+
+collector_t& collector() noexcept
+{
+	static collector_t instance{};
+	return instance;
+}
+
+double to_milliseconds(const steady_clock_t::duration duration) noexcept
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/** Throughput in megabytes per second, or zero if no time was measured. */
+double to_megabytes_per_second(const std::uint64_t bytes, const steady_clock_t::duration duration) noexcept
+{
+	const auto seconds = std::chrono::duration<double>(duration).count();
+	constexpr double bytes_per_megabyte = 1000.0 * 1000.0;
+	return seconds > 0.0 ? static_cast<double>(bytes) / bytes_per_megabyte / seconds : 0.0;
+}
+
+std::string format_table(const josk::stats::report_t& report)
+{
+	std::string output;
+	auto out = std::back_inserter(output);
+	std::format_to(out, "{:<24} {:>12} {:>12} {:>16}\n", "Stage", "Time (ms)", "Allocations", "Allocated bytes");
+	for (const auto& [name, duration, allocations, allocated_bytes] : report.stages)
+	{
+		std::format_to(
+				out, "{:<24} {:>12.3f} {:>12} {:>16}\n", name, to_milliseconds(duration), allocations, allocated_bytes
+		);
+	}
+
+	if (!report.containers.empty())
+	{
+		std::format_to(out, "\n{:<24} {:>12} {:>16}\n", "Container", "Elements", "Retained bytes");
+		for (const auto& [name, size, retained_bytes] : report.containers)
+		{
+			std::format_to(out, "{:<24} {:>12} {:>16}\n", name, size, retained_bytes);
+		}
+	}
+	std::format_to(out, "\nPeak resident bytes: {}\n", report.peak_resident_bytes);
+
+	if (report.plugins.empty())
+	{
+		return output;
+	}
+
+	constexpr std::string_view plugin_row_format{
+			"{:<48} {:>12} {:>9} {:>12} {:>10.3f} {:>10.1f} {:>8} {:>8} {:>8} {:>8} {:>10} {:>12} {:>8} {:>12} {:>14}\n"
+	};
+	std::format_to(
+			out, "\n{:<48} {:>12} {:>9} {:>12} {:>10} {:>10} {:>8} {:>8} {:>8} {:>8} {:>10} {:>12} {:>8} {:>12} {:>14}\n",
+			"Plugin", "File bytes", "Duplicate", "Read bytes", "Time (ms)", "MB/s", "Groups", "Skipped", "Records",
+			"Accepted", "Overridden", "Decompressed", "Topics", "Topic bytes", "Heap fallbacks"
+	);
+	for (const auto& plugin : report.plugins)
+	{
+		std::format_to(
+				out, plugin_row_format, plugin.filename, plugin.file_bytes, plugin.skipped_duplicate ? "yes" : "no",
+				plugin.bytes_read, to_milliseconds(plugin.parse_time),
+				to_megabytes_per_second(plugin.bytes_read, plugin.parse_time), plugin.groups_visited, plugin.groups_skipped,
+				plugin.records_seen, plugin.records_accepted, plugin.records_overridden, plugin.records_decompressed,
+				plugin.topics, plugin.peak_topic_bytes, plugin.heap_fallbacks
+		);
+	}
+	return output;
+}
+
+std::string format_json(const josk::stats::report_t& report)
+{
+	std::string output{"{\"stages\":["};
+	auto out = std::back_inserter(output);
+	for (bool first{true}; const auto& [name, duration, allocations, allocated_bytes] : report.stages)
+	{
+		output.append(first ? "{\"name\":" : ",{\"name\":");
+		josk::json::append_string(output, name);
+		std::format_to(
+				out, ",\"milliseconds\":{},\"allocations\":{},\"allocated_bytes\":{}}}", to_milliseconds(duration),
+				allocations, allocated_bytes
+		);
+		first = false;
+	}
+
+	output.append("],\"containers\":[");
+	for (bool first{true}; const auto& [name, size, retained_bytes] : report.containers)
+	{
+		output.append(first ? "{\"name\":" : ",{\"name\":");
+		josk::json::append_string(output, name);
+		std::format_to(out, ",\"size\":{},\"retained_bytes\":{}}}", size, retained_bytes);
+		first = false;
+	}
+
+	output.append("],\"plugins\":[");
+	for (bool first{true}; const auto& plugin : report.plugins)
+	{
+		output.append(first ? "{\"filename\":" : ",{\"filename\":");
+		josk::json::append_string(output, plugin.filename);
+		std::format_to(
+				out,
+				",\"file_bytes\":{},\"skipped_duplicate\":{},\"bytes_read\":{},\"milliseconds\":{},"
+				"\"megabytes_per_second\":{},\"groups_visited\":{},\"groups_skipped\":{},\"records_seen\":{},"
+				"\"records_accepted\":{},\"records_overridden\":{},\"records_decompressed\":{},\"topics\":{},"
+				"\"peak_topic_bytes\":{},\"heap_fallbacks\":{}}}",
+				plugin.file_bytes, plugin.skipped_duplicate, plugin.bytes_read, to_milliseconds(plugin.parse_time),
+				to_megabytes_per_second(plugin.bytes_read, plugin.parse_time), plugin.groups_visited, plugin.groups_skipped,
+				plugin.records_seen, plugin.records_accepted, plugin.records_overridden, plugin.records_decompressed,
+				plugin.topics, plugin.peak_topic_bytes, plugin.heap_fallbacks
+		);
+		first = false;
+	}
+	std::format_to(out, "],\"peak_resident_bytes\":{}}}\n", report.peak_resident_bytes);
+	return output;
+}
+
+}
+
+namespace josk::stats
+{
+
+const report_t& report() noexcept
+{
+	return collector().report;
+}
+
+void add_stage(const stage_stats_t& stage)
+{
+	const auto peak_resident_bytes = memory::peak_resident_bytes();
+	auto& [mutex, report] = collector();
+	const std::scoped_lock lock{mutex};
+	report.stages.emplace_back(stage);
+	report.peak_resident_bytes = std::max(report.peak_resident_bytes, peak_resident_bytes);
+}
+
+void add_container(const container_stats_t& container)
+{
+	auto& [mutex, report] = collector();
+	const std::scoped_lock lock{mutex};
+	report.containers.emplace_back(container);
+}
+
+void add_plugins(std::vector<plugin_stats_t> plugins)
+{
+	auto& [mutex, report] = collector();
+	const std::scoped_lock lock{mutex};
+	report.plugins.insert(
+			report.plugins.end(), std::make_move_iterator(plugins.begin()), std::make_move_iterator(plugins.end())
+	);
+}
+
+std::string format_report(const report_t& report, const format_t format)
+{
+	switch (format)
+	{
+		case format_t::table:
+			return format_table(report);
+		case format_t::json:
+			return format_json(report);
+		case format_t::none:
+			break;
+	}
+	return {};
+}
+
+}
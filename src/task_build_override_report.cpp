@@ -0,0 +1,84 @@
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace josk::task
+{
+
+std::vector<record_overrides_t> build_override_report(const record_index_t& index)
+{
+	const stats::stage_timer timer{"build_override_report"};
+	const std::span<const tes::record_handle_t> handles{index.handles};
+
+	std::vector<record_overrides_t> report;
+	for (std::size_t first{}; first < handles.size();)
+	{
+		auto last = first + 1Z;
+		while (last < handles.size() && handles[last].record_id == handles[first].record_id)
+		{
+			++last;
+		}
+		const auto versions = handles.subspan(first, last - first);
+		if (versions.size() > 1Z)
+		{
+			// Versions are sorted by decreasing priority: the winning version comes first and the original one last.
+			const auto winner_fingerprint = versions.front().fingerprint;
+			const auto master_fingerprint = versions.back().fingerprint;
+			record_overrides_t overrides{
+					.record_id = versions.front().record_id,
+					.record_type = versions.front().record_type,
+					.first_handle = static_cast<std::uint32_t>(first),
+					.version_count = static_cast<std::uint32_t>(versions.size()),
+			};
+			for (std::size_t version{}; version + 1Z < versions.size(); ++version)
+			{
+				const auto fingerprint = versions[version].fingerprint;
+				if (fingerprint == master_fingerprint)
+				{
+					++overrides.identical_to_master;
+				}
+				else if (version != 0Z && fingerprint != winner_fingerprint)
+				{
+					++overrides.lost_overrides;
+				}
+			}
+			report.emplace_back(overrides);
+		}
+		first = last;
+	}
+
+	if constexpr (stats::enabled)
+	{
+		stats::add_container({"override_report", report.size(), stats::retained_bytes(report)});
+	}
+	return report;
+}
+
+std::expected<extracted_data_t, std::string> add_override_report(
+		extracted_data_t data, std::vector<plugin_t> plugins, const tes::record_type_set_t record_types
+)
+{
+	auto index = index_plugins(std::move(plugins), record_types);
+	if (!index.has_value())
+	{
+		return std::unexpected(std::move(index.error()));
+	}
+	return add_override_report(std::move(data), std::move(index.value()));
+}
+
+extracted_data_t add_override_report(extracted_data_t data, record_index_t index)
+{
+	auto records = build_override_report(index);
+	data.override_report = override_report_t{.index = std::move(index), .records = std::move(records)};
+	return data;
+}
+
+}
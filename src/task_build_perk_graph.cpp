@@ -0,0 +1,173 @@
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using josk::stats::retained_bytes;
+using josk::task::invalid_record_position;
+using josk::task::record_position_t;
+
+/** Maps each formid to the position of its record. */
+using record_positions_t = std::unordered_map<josk::tes::formid_t, record_position_t>;
+
+record_position_t find_position(const record_positions_t& positions, const josk::tes::formid_t record_id) noexcept
+{
+	const auto itr = positions.find(record_id);
+	return itr == positions.cend() ? invalid_record_position : itr->second;
+}
+
+/**
+ * Builds compressed sparse row offsets and targets from a list of edges.
+ * @param node_count Number of nodes.
+ * @param edges Pairs of source and target nodes.
+ * @param offsets Receives node_count + 1 offsets into targets.
+ * @param targets Receives the targets of each node, sorted by source node.
+ */
+template <typename Target>
+void to_compressed_rows(
+		const std::size_t node_count, const std::span<const std::pair<std::uint32_t, Target>> edges,
+		std::vector<std::uint32_t>& offsets, std::vector<Target>& targets
+)
+{
+	offsets.assign(node_count + 1Z, 0U);
+	for (const auto& edge : edges)
+	{
+		++offsets[edge.first + 1Z];
+	}
+	for (std::size_t node{}; node < node_count; ++node)
+	{
+		offsets[node + 1Z] += offsets[node];
+	}
+
+	targets.resize(edges.size());
+	std::vector<std::uint32_t> next_slot(offsets.cbegin(), offsets.cend() - 1);
+	for (const auto& [source, target] : edges)
+	{
+		targets[next_slot[source]++] = target;
+	}
+}
+
+/**
+ * Builds the skill tree of an AVIF record. A node unlocks every node of the same tree which has its perk as a
+ * prerequisite.
+ * @param avif_record AVIF record.
+ * @param avif_position Position of the AVIF record.
+ * @param perk_positions Position of each perk record.
+ * @param graph Perk graph with its prerequisites already resolved.
+ * @return Skill tree.
+ */
+josk::task::perk_tree_t build_tree(
+		const josk::tes::avif_record& avif_record, const record_position_t avif_position,
+		const record_positions_t& perk_positions, const josk::task::perk_graph_t& graph
+)
+{
+	josk::task::perk_tree_t tree{};
+	tree.avif_position = avif_position;
+	tree.nodes.reserve(avif_record.perks.size());
+	// Node of each perk record of this tree. Perks placed twice in the same tree keep their first node.
+	std::unordered_map<record_position_t, std::uint32_t> perk_nodes;
+	for (const auto& avif_perk : avif_record.perks)
+	{
+		const auto perk_position = find_position(perk_positions, avif_perk.record_id);
+		if (perk_position != invalid_record_position)
+		{
+			perk_nodes.emplace(perk_position, static_cast<std::uint32_t>(tree.nodes.size()));
+		}
+		tree.nodes.emplace_back(perk_position);
+	}
+
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+	for (std::uint32_t node{}; node < tree.nodes.size(); ++node)
+	{
+		if (tree.nodes[node] == invalid_record_position)
+		{
+			continue;
+		}
+		for (const auto prerequisite : graph.perk_prerequisites(tree.nodes[node]))
+		{
+			if (const auto itr = perk_nodes.find(prerequisite); itr != perk_nodes.cend())
+			{
+				edges.emplace_back(itr->second, node);
+			}
+		}
+	}
+	to_compressed_rows<std::uint32_t>(tree.nodes.size(), edges, tree.child_offsets, tree.children);
+	return tree;
+}
+
+}
+
+namespace josk::task
+{
+
+std::span<const record_position_t> perk_graph_t::perk_prerequisites(
+		const record_position_t perk_position
+) const noexcept
+{
+	const auto begin = prerequisite_offsets[perk_position];
+	const auto end = prerequisite_offsets[perk_position + 1Z];
+	return std::span{prerequisites}.subspan(begin, end - begin);
+}
+
+perk_graph_t build_perk_graph(const tes::parsed_records_t& records)
+{
+	const stats::stage_timer timer{"build_perk_graph"};
+	const auto& perk_records = records.perk_records;
+
+	record_positions_t perk_positions;
+	perk_positions.reserve(perk_records.size());
+	for (record_position_t position{}; position < perk_records.size(); ++position)
+	{
+		perk_positions.emplace(perk_records[position].record_id, position);
+	}
+
+	perk_graph_t graph{};
+	graph.next_ranks.reserve(perk_records.size());
+	std::vector<std::pair<std::uint32_t, record_position_t>> prerequisite_edges;
+	for (record_position_t position{}; position < perk_records.size(); ++position)
+	{
+		const auto& perk_record = perk_records[position];
+		graph.next_ranks.emplace_back(find_position(perk_positions, perk_record.next_perk_id));
+		for (const auto prerequisite_id : perk_record.prereq_perk_ids)
+		{
+			if (const auto prerequisite = find_position(perk_positions, prerequisite_id);
+					prerequisite != invalid_record_position)
+			{
+				prerequisite_edges.emplace_back(position, prerequisite);
+			}
+		}
+	}
+	to_compressed_rows<record_position_t>(
+			perk_records.size(), prerequisite_edges, graph.prerequisite_offsets, graph.prerequisites
+	);
+
+	graph.trees.reserve(records.avif_records.size());
+	for (record_position_t position{}; position < records.avif_records.size(); ++position)
+	{
+		graph.trees.emplace_back(build_tree(records.avif_records[position], position, perk_positions, graph));
+	}
+
+	if constexpr (stats::enabled)
+	{
+		auto graph_bytes = retained_bytes(graph.next_ranks) + retained_bytes(graph.prerequisite_offsets) +
+											 retained_bytes(graph.prerequisites) + retained_bytes(graph.trees);
+		for (const auto& tree : graph.trees)
+		{
+			graph_bytes += retained_bytes(tree.nodes) + retained_bytes(tree.child_offsets) + retained_bytes(tree.children);
+		}
+		stats::add_container({"perk_graph", perk_records.size(), graph_bytes});
+	}
+	return graph;
+}
+
+}
@@ -0,0 +1,100 @@
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using josk::stats::retained_bytes;
+using josk::task::inverted_index_t;
+using josk::task::record_position_t;
+
+std::uint64_t retained_bytes(const inverted_index_t& index) noexcept
+{
+	return retained_bytes(index.keys) + retained_bytes(index.offsets) + retained_bytes(index.values);
+}
+
+}
+
+namespace josk::task
+{
+
+inverted_index_t to_inverted_index(std::vector<record_reference_t> references)
+{
+	std::ranges::sort(references);
+	const auto [unique_end, references_end] = std::ranges::unique(references);
+	references.erase(unique_end, references_end);
+
+	inverted_index_t index{};
+	index.values.reserve(references.size());
+	for (const auto& [key, value] : references)
+	{
+		if (index.keys.empty() || index.keys.back() != key)
+		{
+			index.keys.emplace_back(key);
+			index.offsets.emplace_back(static_cast<std::uint32_t>(index.values.size()));
+		}
+		index.values.emplace_back(value);
+	}
+	index.offsets.emplace_back(static_cast<std::uint32_t>(index.values.size()));
+	return index;
+}
+
+std::span<const record_position_t> inverted_index_t::find(const tes::formid_t key) const noexcept
+{
+	const auto itr = std::ranges::lower_bound(keys, key);
+	if (itr == keys.cend() || *itr != key)
+	{
+		return {};
+	}
+	const auto key_index = static_cast<std::size_t>(std::distance(keys.cbegin(), itr));
+	const auto begin = offsets[key_index];
+	return std::span{values}.subspan(begin, offsets[key_index + 1Z] - begin);
+}
+
+recipe_index_t build_recipe_index(const tes::parsed_records_t& records)
+{
+	const stats::stage_timer timer{"build_recipe_index"};
+	const auto& cobj_records = records.cobj_records;
+
+	// Single pass over the recipes, gathering the references of both indexes.
+	std::vector<record_reference_t> created_objects;
+	created_objects.reserve(cobj_records.size());
+	std::vector<record_reference_t> components;
+	for (record_position_t position{}; position < cobj_records.size(); ++position)
+	{
+		const auto& cobj_record = cobj_records[position];
+		if (cobj_record.created_object_id != tes::invalid_formid)
+		{
+			created_objects.emplace_back(cobj_record.created_object_id, position);
+		}
+		for (const auto& component : cobj_record.components)
+		{
+			components.emplace_back(component.record_id, position);
+		}
+	}
+
+	recipe_index_t index{};
+	index.created_objects = to_inverted_index(std::move(created_objects));
+	index.components = to_inverted_index(std::move(components));
+
+	if constexpr (stats::enabled)
+	{
+		const auto index_bytes = retained_bytes(index.created_objects) + retained_bytes(index.components);
+		stats::add_container(
+				{"recipe_index", index.created_objects.keys.size() + index.components.keys.size(), index_bytes}
+		);
+	}
+	return index;
+}
+
+}
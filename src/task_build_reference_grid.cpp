@@ -0,0 +1,168 @@
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using josk::stats::retained_bytes;
+using josk::task::cell_coordinates_t;
+using josk::task::record_position_t;
+using josk::task::world_grid_t;
+
+/** Reference placed in an exterior cell of a worldspace. */
+using exterior_reference_t = std::tuple<josk::tes::formid_t, cell_coordinates_t, record_position_t>;
+
+/**
+ * Grid coordinate containing a position coordinate.
+ * @param coordinate Position coordinate in game units.
+ * @return Grid coordinate. Zero for positions which are not finite.
+ */
+std::int32_t to_cell_coordinate(const float coordinate) noexcept
+{
+	if (!std::isfinite(coordinate))
+	{
+		return 0;
+	}
+	// Far beyond the limits of any worldspace. Prevents overflows when converting the coordinate.
+	constexpr float max_coordinate = 1.0e6F;
+	return static_cast<std::int32_t>(
+			std::clamp(std::floor(coordinate / josk::tes::exterior_cell_size), -max_coordinate, max_coordinate)
+	);
+}
+
+}
+
+namespace josk::task
+{
+
+cell_coordinates_t to_cell_coordinates(const std::array<float, 3Z>& position) noexcept
+{
+	return {.x = to_cell_coordinate(position[0Z]), .y = to_cell_coordinate(position[1Z])};
+}
+
+std::span<const record_position_t> world_grid_t::cell_references(const cell_coordinates_t cell) const noexcept
+{
+	const auto itr = std::ranges::lower_bound(cells, cell);
+	if (itr == cells.cend() || *itr != cell)
+	{
+		return {};
+	}
+	const auto cell_index = static_cast<std::size_t>(std::distance(cells.cbegin(), itr));
+	const auto begin = offsets[cell_index];
+	return std::span{references}.subspan(begin, offsets[cell_index + 1Z] - begin);
+}
+
+std::vector<record_position_t> world_grid_t::range_references(
+		const cell_coordinates_t min, const cell_coordinates_t max
+) const
+{
+	std::vector<record_position_t> result;
+	if (max.x < min.x || max.y < min.y)
+	{
+		return result;
+	}
+
+	// Cells of a column are consecutive, and so are their references.
+	auto itr = std::ranges::lower_bound(cells, min);
+	while (itr != cells.cend() && itr->x <= max.x)
+	{
+		const auto column_x = itr->x;
+		const cell_coordinates_t column_min{.x = column_x, .y = min.y};
+		const cell_coordinates_t column_max{.x = column_x, .y = max.y};
+		const auto column_begin = std::ranges::lower_bound(itr, cells.cend(), column_min);
+		const auto column_end = std::ranges::upper_bound(column_begin, cells.cend(), column_max);
+		const auto first_cell = static_cast<std::size_t>(std::distance(cells.cbegin(), column_begin));
+		const auto last_cell = static_cast<std::size_t>(std::distance(cells.cbegin(), column_end));
+		result.insert(result.cend(), references.cbegin() + offsets[first_cell], references.cbegin() + offsets[last_cell]);
+
+		if (column_x == max.x)
+		{
+			break;
+		}
+		itr = std::ranges::lower_bound(column_end, cells.cend(), cell_coordinates_t{.x = column_x + 1, .y = min.y});
+	}
+	return result;
+}
+
+const world_grid_t* reference_grid_t::find_world(const tes::formid_t world_id) const noexcept
+{
+	const auto itr = std::ranges::lower_bound(worlds, world_id, {}, &world_grid_t::world_id);
+	return itr == worlds.cend() || itr->world_id != world_id ? nullptr : &*itr;
+}
+
+reference_grid_t build_reference_grid(const tes::parsed_records_t& records)
+{
+	const stats::stage_timer timer{"build_reference_grid"};
+	const auto& references = records.placed_references;
+
+	// Single pass over the references, splitting them between worldspaces and interior cells.
+	std::vector<exterior_reference_t> exterior_references;
+	std::vector<record_reference_t> interior_references;
+	for (record_position_t position{}; position < references.size(); ++position)
+	{
+		const auto& reference = references[position];
+		if (reference.world_id == tes::invalid_formid)
+		{
+			interior_references.emplace_back(reference.cell_id, position);
+		}
+		else
+		{
+			exterior_references.emplace_back(reference.world_id, to_cell_coordinates(reference.position), position);
+		}
+	}
+	std::ranges::sort(exterior_references);
+
+	reference_grid_t grid{};
+	for (const auto& [world_id, cell, position] : exterior_references)
+	{
+		if (grid.worlds.empty() || grid.worlds.back().world_id != world_id)
+		{
+			if (!grid.worlds.empty())
+			{
+				auto& previous_world = grid.worlds.back();
+				previous_world.offsets.emplace_back(static_cast<std::uint32_t>(previous_world.references.size()));
+			}
+			grid.worlds.emplace_back().world_id = world_id;
+		}
+		auto& world = grid.worlds.back();
+		if (world.cells.empty() || world.cells.back() != cell)
+		{
+			world.cells.emplace_back(cell);
+			world.offsets.emplace_back(static_cast<std::uint32_t>(world.references.size()));
+		}
+		world.references.emplace_back(position);
+	}
+	if (!grid.worlds.empty())
+	{
+		auto& last_world = grid.worlds.back();
+		last_world.offsets.emplace_back(static_cast<std::uint32_t>(last_world.references.size()));
+	}
+	grid.interior_cells = to_inverted_index(std::move(interior_references));
+
+	if constexpr (stats::enabled)
+	{
+		auto grid_bytes = retained_bytes(grid.worlds) + retained_bytes(grid.interior_cells.keys) +
+											retained_bytes(grid.interior_cells.offsets) + retained_bytes(grid.interior_cells.values);
+		for (const auto& world : grid.worlds)
+		{
+			grid_bytes += retained_bytes(world.cells) + retained_bytes(world.offsets) + retained_bytes(world.references);
+		}
+		stats::add_container({"reference_grid", references.size(), grid_bytes});
+	}
+	return grid;
+}
+
+}
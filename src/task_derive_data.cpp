@@ -0,0 +1,36 @@
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace josk::task
+{
+
+inverted_index_t index_topic_infos(const tes::parsed_records_t& records)
+{
+	const stats::stage_timer timer{"index_topic_infos"};
+	const auto& info_records = records.info_records;
+	std::vector<record_reference_t> topic_infos;
+	topic_infos.reserve(info_records.size());
+	for (record_position_t position{}; position < info_records.size(); ++position)
+	{
+		topic_infos.emplace_back(info_records[position].topic_id, position);
+	}
+	return to_inverted_index(std::move(topic_infos));
+}
+
+extracted_data_t derive_data(tes::parsed_records_t records)
+{
+	extracted_data_t data{};
+	data.perk_graph = build_perk_graph(records);
+	data.leveled_lists = flatten_leveled_lists(records);
+	data.recipe_index = build_recipe_index(records);
+	data.reference_grid = build_reference_grid(records);
+	data.topic_infos = index_topic_infos(records);
+	data.records = std::move(records);
+	return data;
+}
+
+}
@@ -0,0 +1,220 @@
+#include <josk/cli.hpp>
+#include <josk/json.hpp>
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using namespace josk::task;
+
+/**
+ * Finds the winning version of each record of a snapshot.
+ * @param snapshot Snapshot to check.
+ * @return Handle of the winning version of each record, sorted by formid.
+ */
+std::vector<josk::tes::record_handle_t> find_winners(const modlist_snapshot_t& snapshot)
+{
+	std::vector<josk::tes::record_handle_t> handles;
+	for (const auto& plugin : snapshot.plugins)
+	{
+		handles.insert(handles.end(), plugin.handles.cbegin(), plugin.handles.cend());
+	}
+	std::ranges::sort(
+			handles,
+			[](const josk::tes::record_handle_t& lhs, const josk::tes::record_handle_t& rhs)
+			{ return lhs.record_id < rhs.record_id || (lhs.record_id == rhs.record_id && lhs.priority > rhs.priority); }
+	);
+	const auto [unique_end, handles_end] = std::ranges::unique(handles, {}, &josk::tes::record_handle_t::record_id);
+	handles.erase(unique_end, handles_end);
+	return handles;
+}
+
+constexpr std::string_view to_change_string(const record_change_kind_t kind) noexcept
+{
+	switch (kind)
+	{
+		case record_change_kind_t::added:
+			return "added";
+		case record_change_kind_t::removed:
+			return "removed";
+		case record_change_kind_t::changed:
+			return "changed";
+	}
+	return "changed";
+}
+
+void append_plugin(std::string& output, const modlist_snapshot_t& snapshot, const std::uint32_t position)
+{
+	if (position == record_change_t::invalid_plugin)
+	{
+		output.append("null");
+	}
+	else
+	{
+		josk::json::append_string(output, snapshot.plugins[position].filename);
+	}
+}
+
+/**
+ * Writes the changes between two snapshots as a JSON array.
+ * @param path Path of the output file.
+ * @param base Snapshot taken first.
+ * @param target Snapshot taken later.
+ * @param changes Changes between both snapshots.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> write_changes(
+		const std::filesystem::path& path, const modlist_snapshot_t& base, const modlist_snapshot_t& target,
+		const std::vector<record_change_t>& changes
+)
+{
+	std::string output{"["};
+	for (bool first{true}; const auto& change : changes)
+	{
+		std::format_to(
+				std::back_inserter(output), "{}\n{{\"record_id\":{},\"type\":\"{}\",\"change\":\"{}\",\"base_plugin\":",
+				first ? "" : ",", change.record_id, josk::tes::to_record_string(change.record_type),
+				to_change_string(change.kind)
+		);
+		append_plugin(output, base, change.base_plugin);
+		output.append(",\"target_plugin\":");
+		append_plugin(output, target, change.target_plugin);
+		output.push_back('}');
+		first = false;
+	}
+	output.append("\n]\n");
+
+	std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+	file.write(output.data(), static_cast<std::streamsize>(output.size()));
+	if (!file.good())
+	{
+		return std::unexpected(std::format("Could not write output file {}.", path.generic_string()));
+	}
+	return {};
+}
+
+}
+
+namespace josk::task
+{
+
+std::vector<record_change_t> diff_snapshots(const modlist_snapshot_t& base, const modlist_snapshot_t& target)
+{
+	const stats::stage_timer timer{"diff_snapshots"};
+	const auto base_winners = find_winners(base);
+	const auto target_winners = find_winners(target);
+	const auto to_plugin = [](const tes::record_handle_t& handle) { return static_cast<std::uint32_t>(handle.priority); };
+
+	std::vector<record_change_t> changes;
+	auto base_itr = base_winners.cbegin();
+	auto target_itr = target_winners.cbegin();
+	while (base_itr != base_winners.cend() || target_itr != target_winners.cend())
+	{
+		if (target_itr == target_winners.cend() ||
+				(base_itr != base_winners.cend() && base_itr->record_id < target_itr->record_id))
+		{
+			changes.emplace_back(
+					base_itr->record_id, base_itr->record_type, record_change_kind_t::removed, to_plugin(*base_itr),
+					record_change_t::invalid_plugin
+			);
+			++base_itr;
+		}
+		else if (base_itr == base_winners.cend() || target_itr->record_id < base_itr->record_id)
+		{
+			changes.emplace_back(
+					target_itr->record_id, target_itr->record_type, record_change_kind_t::added,
+					record_change_t::invalid_plugin, to_plugin(*target_itr)
+			);
+			++target_itr;
+		}
+		else
+		{
+			if (base_itr->fingerprint != target_itr->fingerprint || base_itr->record_type != target_itr->record_type)
+			{
+				changes.emplace_back(
+						target_itr->record_id, target_itr->record_type, record_change_kind_t::changed, to_plugin(*base_itr),
+						to_plugin(*target_itr)
+				);
+			}
+			++base_itr;
+			++target_itr;
+		}
+	}
+
+	if constexpr (stats::enabled)
+	{
+		stats::add_container({"record_changes", changes.size(), stats::retained_bytes(changes)});
+	}
+	return changes;
+}
+
+std::expected<void, std::string> diff_modlists(cli::arguments_t arguments)
+{
+	const stats::stage_timer timer{"diff_modlists"};
+	const auto record_types = arguments.record_types;
+	const auto snapshot_profile = [record_types](cli::arguments_t profile_arguments, const modlist_snapshot_t* reusable)
+	{
+		return parse_load_order(std::move(profile_arguments))
+				.and_then(find_plugins)
+				.and_then([record_types, reusable](const std::vector<plugin_t>& plugins)
+									{ return snapshot_plugins(plugins, record_types, reusable); });
+	};
+
+	const auto& diff_arguments = arguments.diff;
+	std::expected<modlist_snapshot_t, std::string> base{modlist_snapshot_t{.record_types = record_types, .plugins = {}}};
+	if (!diff_arguments.base_snapshot_path.empty())
+	{
+		base = read_snapshot(diff_arguments.base_snapshot_path);
+	}
+	else if (!diff_arguments.base_profile_path.empty())
+	{
+		auto base_arguments = arguments;
+		base_arguments.profile_path = diff_arguments.base_profile_path;
+		base = snapshot_profile(std::move(base_arguments), nullptr);
+	}
+	if (!base.has_value())
+	{
+		return std::unexpected(std::move(base.error()));
+	}
+	if (base->record_types != record_types)
+	{
+		return std::unexpected("The base snapshot was saved with different record types than the requested ones.");
+	}
+
+	// Plugins which are byte-identical in both sides are taken from the base snapshot without parsing them again.
+	const auto target = snapshot_profile(arguments, &base.value());
+	if (!target.has_value())
+	{
+		return std::unexpected(target.error());
+	}
+	const auto changes = diff_snapshots(base.value(), target.value());
+	return write_changes(arguments.output_path / "diff.json", base.value(), target.value(), changes)
+			.and_then(
+					[&diff_arguments, &target]() -> std::expected<void, std::string>
+					{
+						if (diff_arguments.save_snapshot_path.empty())
+						{
+							return {};
+						}
+						return write_snapshot(target.value(), diff_arguments.save_snapshot_path);
+					}
+			);
+}
+
+}
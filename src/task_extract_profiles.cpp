@@ -0,0 +1,135 @@
+#include <josk/cli.hpp>
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <ranges>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using namespace josk::task;
+
+/**
+ * Copies the records of a plugin which have not been added by a plugin with higher priority.
+ * @param winners Records of this type added by plugins with higher priority.
+ * @param winner_ids Formids of every record added by plugins with higher priority.
+ * @param plugin_records Records of this type of the plugin.
+ */
+template <typename Record>
+void append_winners(
+		std::vector<Record>& winners, std::unordered_set<josk::tes::formid_t>& winner_ids,
+		const std::vector<Record>& plugin_records
+)
+{
+	for (const auto& record : plugin_records)
+	{
+		if (winner_ids.emplace(record.record_id).second)
+		{
+			winners.emplace_back(record);
+		}
+	}
+}
+
+/**
+ * Applies load order rules to records parsed from each plugin on its own.
+ * @param plugin_records Records of each plugin of the load order, sorted by inverse load order.
+ * @return Parsed records following load order rules, in the same order as the ones of parse_plugins.
+ */
+josk::tes::parsed_records_t merge_profile(const std::vector<const josk::tes::parsed_records_t*>& plugin_records)
+{
+	josk::tes::parsed_records_t parsed_records{};
+	auto& ids = parsed_records.parsed_record_ids;
+	for (const auto* records : plugin_records)
+	{
+		append_winners(parsed_records.avif_records, ids, records->avif_records);
+		append_winners(parsed_records.perk_records, ids, records->perk_records);
+		append_winners(parsed_records.leveled_list_records, ids, records->leveled_list_records);
+		append_winners(parsed_records.cobj_records, ids, records->cobj_records);
+		append_winners(parsed_records.placed_references, ids, records->placed_references);
+		append_winners(parsed_records.dial_records, ids, records->dial_records);
+		append_winners(parsed_records.info_records, ids, records->info_records);
+	}
+	return parsed_records;
+}
+
+}
+
+namespace josk::task
+{
+
+std::expected<void, std::string> extract_profiles(cli::arguments_t arguments)
+{
+	const stats::stage_timer timer{"extract_profiles"};
+
+	// Plugins found in more than one profile are only parsed once.
+	std::vector<std::vector<plugin_t>> profile_plugins;
+	std::vector<plugin_t> unique_plugins;
+	std::unordered_map<std::filesystem::path, std::size_t> plugin_positions;
+	for (const auto& profile_path : arguments.batch_profile_paths)
+	{
+		auto profile_arguments = arguments;
+		profile_arguments.profile_path = profile_path;
+		auto plugins = parse_load_order(std::move(profile_arguments)).and_then(find_plugins);
+		if (!plugins.has_value())
+		{
+			return std::unexpected(std::format("Profile {}: {}", profile_path.string(), plugins.error()));
+		}
+		for (const auto& plugin : plugins.value())
+		{
+			if (plugin_positions.emplace(plugin.path, unique_plugins.size()).second)
+			{
+				unique_plugins.emplace_back(plugin);
+			}
+		}
+		profile_plugins.emplace_back(std::move(plugins.value()));
+	}
+
+	// Byte-identical plugins under different names or paths are also parsed once. Records claimed by other plugins
+	// cannot be skipped, as the priority of each plugin depends on the profile.
+	const auto parsed_plugins =
+			hash_plugins(std::move(unique_plugins))
+					.and_then([&arguments](const std::vector<plugin_t>& plugins)
+										{ return parse_plugins_separately(plugins, arguments.record_types); });
+	if (!parsed_plugins.has_value())
+	{
+		return std::unexpected(parsed_plugins.error());
+	}
+
+	for (std::size_t profile_index{}; profile_index < profile_plugins.size(); ++profile_index)
+	{
+		const auto& plugins = profile_plugins[profile_index];
+		std::vector<const tes::parsed_records_t*> plugin_records;
+		plugin_records.reserve(plugins.size());
+		for (const auto& plugin : plugins | std::views::reverse)
+		{
+			plugin_records.emplace_back(&parsed_plugins.value()[plugin_positions.at(plugin.path)]);
+		}
+
+		const auto output_path = arguments.output_path / arguments.batch_profile_paths[profile_index].filename();
+		std::error_code error{};
+		std::filesystem::create_directory(output_path, error);
+		if (error)
+		{
+			return std::unexpected(std::format("Could not create output folder {}.", output_path.string()));
+		}
+		if (auto result = write_output(derive_data(merge_profile(plugin_records)), output_path); !result.has_value())
+		{
+			return result;
+		}
+	}
+	return {};
+}
+
+}
@@ -1,12 +1,16 @@
+#include <josk/io.hpp>
+#include <josk/stats.hpp>
 #include <josk/tasks.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <expected>
 #include <filesystem>
 #include <ranges>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -17,6 +21,9 @@ namespace
 namespace fs = std::filesystem;
 using namespace josk::task;
 
+/** Plugins read at once by each hash worker. */
+constexpr std::size_t plugins_per_hash_batch = 4Z;
+
 void try_add_plugin(
 		const fs::path& filesystem_path, std::vector<plugin_t>& files, std::unordered_map<std::string, order_t>& load_order
 )
@@ -35,10 +42,10 @@ void try_add_plugin(
 		return;
 	}
 
-	auto& [plugin_order, plugin_filename, plugin_path] = files.emplace_back();
-	plugin_order = itr->second;
-	plugin_filename = std::move(filename_to_test);
-	plugin_path = filesystem_path;
+	auto& plugin = files.emplace_back();
+	plugin.order = itr->second;
+	plugin.filename = std::move(filename_to_test);
+	plugin.path = filesystem_path;
 	// Remove the found plugin from the remaining load order.
 	load_order.erase(itr);
 }
@@ -75,6 +82,7 @@ namespace josk::task
 
 std::expected<std::vector<plugin_t>, std::string> find_plugins(plugins_to_load_t modlist)
 {
+	const stats::stage_timer timer{"find_plugins"};
 	std::vector<plugin_t> files;
 	auto& load_order = modlist.load_order;
 	for (fs::recursive_directory_iterator itr{modlist.mods_path}; itr != fs::recursive_directory_iterator{}; ++itr)
@@ -100,7 +108,69 @@ std::expected<std::vector<plugin_t>, std::string> find_plugins(plugins_to_load_t
 
 	std::ranges::sort(files);
 
+	if (modlist.hash_contents)
+	{
+		return hash_plugins(std::move(files));
+	}
 	return files;
 }
 
+std::expected<std::vector<plugin_t>, std::string> hash_plugins(std::vector<plugin_t> plugins)
+{
+	const stats::stage_timer timer{"hash_plugins"};
+	const auto io_backend = io::available_backend();
+	const auto plugin_count = plugins.size();
+	std::vector<std::expected<void, std::string>> hash_results(plugin_count);
+
+	// Each worker reads and hashes a few plugins at a time, so that memory usage stays bounded.
+	std::atomic<std::size_t> next_index{};
+	const auto hash_worker = [&plugins, &hash_results, &next_index, plugin_count, io_backend]
+	{
+		std::vector<io::read_request_t> read_requests;
+		for (auto batch_begin = next_index.fetch_add(plugins_per_hash_batch); batch_begin < plugin_count;
+				 batch_begin = next_index.fetch_add(plugins_per_hash_batch))
+		{
+			const auto batch_end = std::min(batch_begin + plugins_per_hash_batch, plugin_count);
+			read_requests.clear();
+			for (auto index = batch_begin; index < batch_end; ++index)
+			{
+				read_requests.emplace_back(plugins[index].path);
+			}
+			auto buffers = io::read(read_requests, io_backend);
+			for (auto index = batch_begin; index < batch_end; ++index)
+			{
+				const auto& buffer = buffers[index - batch_begin];
+				if (!buffer.has_value())
+				{
+					hash_results[index] = std::unexpected(buffer.error());
+					continue;
+				}
+				plugins[index].size = buffer->size();
+				plugins[index].content_hash = io::hash_bytes(buffer.value(), 0U);
+			}
+		}
+	};
+
+	{
+		const auto worker_count = std::min<std::size_t>(
+				std::max<std::size_t>(std::thread::hardware_concurrency(), 1Z),
+				(plugin_count + plugins_per_hash_batch - 1Z) / plugins_per_hash_batch
+		);
+		std::vector<std::jthread> workers;
+		for (std::size_t worker{}; worker < worker_count; ++worker)
+		{
+			workers.emplace_back(hash_worker);
+		}
+	}
+
+	for (const auto& hash_result : hash_results)
+	{
+		if (!hash_result.has_value())
+		{
+			return std::unexpected(hash_result.error());
+		}
+	}
+	return plugins;
+}
+
 }
@@ -0,0 +1,282 @@
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using josk::stats::retained_bytes;
+using josk::task::flat_leveled_list_t;
+using josk::task::invalid_record_position;
+using josk::task::leveled_item_t;
+using josk::task::record_position_t;
+
+/** Position of the leveled list referenced by each entry of each list. invalid_record_position for other records. */
+using nested_lists_t = std::vector<std::vector<record_position_t>>;
+
+/** Depth of lists which have not been visited yet. */
+constexpr auto unvisited_depth = std::numeric_limits<std::uint32_t>::max();
+/** Depth of lists whose nested lists are being visited. Reaching one of them again means that there is a cycle. */
+constexpr auto visiting_depth = unvisited_depth - 1U;
+
+/**
+ * Computes the depth of each list. Lists without nested lists have a depth of zero, and the rest are one level deeper
+ * than their deepest nested list. Lists of the same depth do not depend on each other. References closing a cycle are
+ * ignored, and always point to a list with a higher depth.
+ * @param nested_lists Nested lists of each list.
+ * @return Depth of each list.
+ */
+std::vector<std::uint32_t> compute_depths(const nested_lists_t& nested_lists)
+{
+	std::vector<std::uint32_t> depths(nested_lists.size(), unvisited_depth);
+	// Explicit stack of lists being visited and their next entry, as lists can be nested deeply.
+	std::vector<std::pair<record_position_t, std::size_t>> stack;
+	for (record_position_t root{}; root < nested_lists.size(); ++root)
+	{
+		if (depths[root] != unvisited_depth)
+		{
+			continue;
+		}
+		depths[root] = visiting_depth;
+		stack.emplace_back(root, 0Z);
+		while (!stack.empty())
+		{
+			auto& [list, next_entry] = stack.back();
+			const auto& entries = nested_lists[list];
+			if (next_entry < entries.size())
+			{
+				const auto nested_list = entries[next_entry++];
+				if (nested_list != invalid_record_position && depths[nested_list] == unvisited_depth)
+				{
+					depths[nested_list] = visiting_depth;
+					stack.emplace_back(nested_list, 0Z);
+				}
+				continue;
+			}
+
+			std::uint32_t depth{};
+			for (const auto nested_list : entries)
+			{
+				if (nested_list != invalid_record_position && depths[nested_list] < visiting_depth)
+				{
+					depth = std::max(depth, depths[nested_list] + 1U);
+				}
+			}
+			depths[list] = depth;
+			stack.pop_back();
+		}
+	}
+	return depths;
+}
+
+/** Data shared by all lists being flattened. */
+struct flatten_context_t final
+{
+	const std::vector<josk::tes::leveled_list_record>& records;
+	const nested_lists_t& nested_lists;
+	const std::vector<std::uint32_t>& depths;
+	/** Lists of lower depths have already been flattened when a list is processed. */
+	std::vector<flat_leveled_list_t>& flat_lists;
+};
+
+/**
+ * Flattens a single list. All of its nested lists must have been flattened already.
+ * @param context Lists being flattened.
+ * @param position Position of the list.
+ * @param items Scratch buffer, reused between calls.
+ */
+void flatten_list(
+		const flatten_context_t& context, const record_position_t position, std::vector<leveled_item_t>& items
+)
+{
+	const auto& record = context.records[position];
+	const auto& nested_lists = context.nested_lists[position];
+	const auto is_flattened = [&context, position](const record_position_t nested_list)
+	{ return context.depths[nested_list] < context.depths[position]; };
+	auto& flat_list = context.flat_lists[position];
+
+	// The distribution changes at the level of each entry, and at the levels where its nested lists change.
+	for (std::size_t entry_index{}; entry_index < record.entries.size(); ++entry_index)
+	{
+		const auto entry_level = record.entries[entry_index].level;
+		flat_list.levels.emplace_back(entry_level);
+		if (const auto nested_list = nested_lists[entry_index];
+				nested_list != invalid_record_position && is_flattened(nested_list))
+		{
+			for (const auto nested_level : context.flat_lists[nested_list].levels)
+			{
+				flat_list.levels.emplace_back(std::max(nested_level, entry_level));
+			}
+		}
+	}
+	std::ranges::sort(flat_list.levels);
+	const auto [unique_end, levels_end] = std::ranges::unique(flat_list.levels);
+	flat_list.levels.erase(unique_end, levels_end);
+
+	// A chance none global cannot be resolved, so the chance none value of the record is always used.
+	const double chance = static_cast<double>(100U - std::min<std::uint32_t>(record.chance_none, 100U)) / 100.0;
+	const bool all_levels = (record.flags & josk::tes::leveled_all_levels_flag) != 0U;
+	const bool use_all = (record.flags & josk::tes::leveled_use_all_flag) != 0U;
+	flat_list.item_offsets.emplace_back(0U);
+	for (const auto level : flat_list.levels)
+	{
+		// Without the all levels flag, only the entries of the highest level not above the player level are used.
+		std::uint16_t min_level{};
+		if (!all_levels)
+		{
+			for (const auto& entry : record.entries)
+			{
+				if (entry.level <= level)
+				{
+					min_level = std::max(min_level, entry.level);
+				}
+			}
+		}
+		const auto is_eligible = [level, min_level](const josk::tes::leveled_entry& entry)
+		{ return min_level <= entry.level && entry.level <= level; };
+		const auto eligible_count = std::ranges::count_if(record.entries, is_eligible);
+
+		items.clear();
+		// With the use all flag every entry is generated. Otherwise, a single entry is chosen at random.
+		const double weight = use_all ? chance : chance / static_cast<double>(std::max<std::ptrdiff_t>(eligible_count, 1));
+		for (std::size_t entry_index{}; entry_index < record.entries.size(); ++entry_index)
+		{
+			const auto& entry = record.entries[entry_index];
+			if (!is_eligible(entry))
+			{
+				continue;
+			}
+			const auto entry_count = weight * static_cast<double>(entry.count);
+			const auto nested_list = nested_lists[entry_index];
+			if (nested_list == invalid_record_position)
+			{
+				items.emplace_back(entry.record_id, entry_count);
+			}
+			else if (is_flattened(nested_list))
+			{
+				for (const auto& [record_id, count] : context.flat_lists[nested_list].at_level(level))
+				{
+					items.emplace_back(record_id, count * entry_count);
+				}
+			}
+		}
+
+		std::ranges::sort(items, {}, &leveled_item_t::record_id);
+		for (const auto& item : items)
+		{
+			if (flat_list.items.size() > flat_list.item_offsets.back() && flat_list.items.back().record_id == item.record_id)
+			{
+				flat_list.items.back().count += item.count;
+			}
+			else
+			{
+				flat_list.items.emplace_back(item);
+			}
+		}
+		flat_list.item_offsets.emplace_back(static_cast<std::uint32_t>(flat_list.items.size()));
+	}
+}
+
+}
+
+namespace josk::task
+{
+
+std::span<const leveled_item_t> flat_leveled_list_t::at_level(const std::uint16_t level) const noexcept
+{
+	const auto itr = std::ranges::upper_bound(levels, level);
+	if (itr == levels.cbegin())
+	{
+		return {};
+	}
+	const auto distribution = static_cast<std::size_t>(std::distance(levels.cbegin(), itr)) - 1Z;
+	const auto begin = item_offsets[distribution];
+	return std::span{items}.subspan(begin, item_offsets[distribution + 1Z] - begin);
+}
+
+std::vector<flat_leveled_list_t> flatten_leveled_lists(const tes::parsed_records_t& records)
+{
+	const stats::stage_timer timer{"flatten_leveled_lists"};
+	const auto& leveled_lists = records.leveled_list_records;
+	const auto list_count = leveled_lists.size();
+
+	std::unordered_map<tes::formid_t, record_position_t> list_positions;
+	list_positions.reserve(list_count);
+	for (record_position_t position{}; position < list_count; ++position)
+	{
+		list_positions.emplace(leveled_lists[position].record_id, position);
+	}
+	nested_lists_t nested_lists(list_count);
+	for (std::size_t position{}; position < list_count; ++position)
+	{
+		for (const auto& entry : leveled_lists[position].entries)
+		{
+			const auto itr = list_positions.find(entry.record_id);
+			nested_lists[position].emplace_back(itr == list_positions.cend() ? invalid_record_position : itr->second);
+		}
+	}
+	const auto depths = compute_depths(nested_lists);
+
+	// Lists sorted by depth. Each depth only depends on lower ones.
+	std::vector<record_position_t> order(list_count);
+	for (record_position_t position{}; position < list_count; ++position)
+	{
+		order[position] = position;
+	}
+	std::ranges::sort(order, {}, [&depths](const record_position_t position) { return depths[position]; });
+
+	std::vector<flat_leveled_list_t> flat_lists(list_count);
+	const flatten_context_t context{leveled_lists, nested_lists, depths, flat_lists};
+	const auto worker_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1Z);
+	for (auto depth_begin = order.cbegin(); depth_begin != order.cend();)
+	{
+		const auto depth_end = std::ranges::find_if(
+				depth_begin, order.cend(),
+				[&depths, depth = depths[*depth_begin]](const record_position_t position) { return depths[position] != depth; }
+		);
+		const std::span<const record_position_t> depth_lists{depth_begin, depth_end};
+
+		std::atomic<std::size_t> next_index{};
+		const auto flatten_worker = [&context, &next_index, depth_lists]
+		{
+			std::vector<leveled_item_t> items;
+			for (auto index = next_index.fetch_add(1Z); index < depth_lists.size(); index = next_index.fetch_add(1Z))
+			{
+				flatten_list(context, depth_lists[index], items);
+			}
+		};
+		std::vector<std::jthread> workers;
+		for (std::size_t worker{}; worker < std::min(worker_count, depth_lists.size()); ++worker)
+		{
+			workers.emplace_back(flatten_worker);
+		}
+		depth_begin = depth_end;
+	}
+
+	if constexpr (stats::enabled)
+	{
+		auto flat_bytes = retained_bytes(flat_lists);
+		for (const auto& flat_list : flat_lists)
+		{
+			flat_bytes +=
+					retained_bytes(flat_list.levels) + retained_bytes(flat_list.item_offsets) + retained_bytes(flat_list.items);
+		}
+		stats::add_container({"flat_leveled_lists", flat_lists.size(), flat_bytes});
+	}
+	return flat_lists;
+}
+
+}
@@ -0,0 +1,224 @@
+#include <josk/arena.hpp>
+#include <josk/io.hpp>
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <format>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using namespace josk::task;
+
+/** Maximum amount of records read and decoded at the same time by materialize_index. */
+constexpr std::size_t records_per_materialize_batch = 4096Z;
+
+/**
+ * Moves all records from one instance into another.
+ * @param source Records to move.
+ * @param destination Records receiving them.
+ */
+void append_records(josk::tes::parsed_records_t source, josk::tes::parsed_records_t& destination)
+{
+	destination.parsed_record_ids.merge(source.parsed_record_ids);
+	std::ranges::move(source.avif_records, std::back_inserter(destination.avif_records));
+	std::ranges::move(source.perk_records, std::back_inserter(destination.perk_records));
+	std::ranges::move(source.leveled_list_records, std::back_inserter(destination.leveled_list_records));
+	std::ranges::move(source.cobj_records, std::back_inserter(destination.cobj_records));
+	std::ranges::move(source.placed_references, std::back_inserter(destination.placed_references));
+	std::ranges::move(source.dial_records, std::back_inserter(destination.dial_records));
+	std::ranges::move(source.info_records, std::back_inserter(destination.info_records));
+}
+
+}
+
+namespace josk::task
+{
+
+std::span<const tes::record_handle_t> record_index_t::versions(const tes::formid_t record_id) const noexcept
+{
+	const auto range = std::ranges::equal_range(handles, record_id, {}, &tes::record_handle_t::record_id);
+	return {range.begin(), range.end()};
+}
+
+const plugin_t* record_index_t::find_plugin(const tes::record_handle_t& handle) const noexcept
+{
+	const auto itr = std::ranges::lower_bound(plugins, handle.priority, {}, &plugin_t::order);
+	if (itr == plugins.cend() || itr->order != handle.priority)
+	{
+		return nullptr;
+	}
+	return &*itr;
+}
+
+std::vector<tes::formid_t> record_index_t::record_ids(const tes::record_type_t record_type) const
+{
+	std::vector<tes::formid_t> ids;
+	for (const auto& handle : handles)
+	{
+		if (handle.record_type == record_type && (ids.empty() || ids.back() != handle.record_id))
+		{
+			ids.emplace_back(handle.record_id);
+		}
+	}
+	return ids;
+}
+
+std::expected<tes::parsed_records_t, std::string> materialize_records(
+		const record_index_t& index, const std::span<const tes::formid_t> record_ids
+)
+{
+	std::vector<tes::formid_t> unique_ids(record_ids.begin(), record_ids.end());
+	std::ranges::sort(unique_ids);
+	const auto [unique_end, ids_end] = std::ranges::unique(unique_ids);
+	unique_ids.erase(unique_end, ids_end);
+
+	// Remaining versions of each record pending to be decoded, starting from the one with the highest priority.
+	std::vector<std::span<const tes::record_handle_t>> pending;
+	for (const auto record_id : unique_ids)
+	{
+		if (const auto versions = index.versions(record_id); !versions.empty())
+		{
+			pending.emplace_back(versions);
+		}
+	}
+
+	tes::parsed_records_t parsed_records{};
+	memory::arena_t arena{};
+	const auto io_backend = io::available_backend();
+	std::vector<io::read_request_t> read_requests;
+	std::vector<std::span<const tes::record_handle_t>> rejected;
+	// Each round reads and decodes the best remaining version of every pending record in a single batch, which opens
+	// each plugin only once. Most records are accepted in the first round. Rejected versions fall back to the next one.
+	while (!pending.empty())
+	{
+		read_requests.clear();
+		for (const auto& versions : pending)
+		{
+			const auto& handle = versions.front();
+			const auto* plugin = index.find_plugin(handle);
+			if (plugin == nullptr)
+			{
+				return std::unexpected(std::format("Record index has no plugin with priority {}.", handle.priority));
+			}
+			read_requests.emplace_back(plugin->path, handle.offset, handle.size);
+		}
+		auto buffers = io::read(read_requests, io_backend);
+
+		rejected.clear();
+		for (auto&& [versions, buffer] : std::views::zip(pending, buffers))
+		{
+			if (!buffer.has_value())
+			{
+				return std::unexpected(std::move(buffer.error()));
+			}
+			const auto& handle = versions.front();
+			const auto decode_result = tes::decode_record(
+					handle, index.find_plugin(handle)->filename, std::move(buffer.value()), parsed_records, arena.resource()
+			);
+			arena.reset();
+			if (!decode_result.has_value())
+			{
+				return std::unexpected(decode_result.error());
+			}
+			if (decode_result.value())
+			{
+				parsed_records.parsed_record_ids.emplace(handle.record_id);
+			}
+			else if (versions.size() > 1Z)
+			{
+				rejected.emplace_back(versions.subspan(1Z));
+			}
+		}
+		std::swap(pending, rejected);
+	}
+
+	return parsed_records;
+}
+
+std::expected<tes::parsed_records_t, std::string> materialize_index(const record_index_t& index)
+{
+	const stats::stage_timer timer{"materialize_index"};
+	std::vector<tes::formid_t> record_ids;
+	for (const auto& handle : index.handles)
+	{
+		if (record_ids.empty() || record_ids.back() != handle.record_id)
+		{
+			record_ids.emplace_back(handle.record_id);
+		}
+	}
+
+	// Records are decoded in batches, so that only the data of a batch is kept in memory at the same time.
+	tes::parsed_records_t parsed_records{};
+	for (const auto batch : record_ids | std::views::chunk(records_per_materialize_batch))
+	{
+		auto batch_result = materialize_records(index, batch);
+		if (!batch_result.has_value())
+		{
+			return batch_result;
+		}
+		append_records(std::move(batch_result.value()), parsed_records);
+	}
+	return parsed_records;
+}
+
+std::expected<tes::parsed_records_t, std::string> materialize_plugins(
+		const std::vector<plugin_t>& plugins, const tes::record_type_set_t record_types
+)
+{
+	return index_plugins(plugins, record_types).and_then(materialize_index);
+}
+
+std::expected<tes::parsed_records_t, std::string> materialize_perk_tree(
+		const record_index_t& index, const tes::formid_t avif_id
+)
+{
+	auto tree_result = materialize_records(index, std::span{&avif_id, 1Z});
+	if (!tree_result.has_value() || tree_result->avif_records.empty())
+	{
+		return tree_result;
+	}
+	auto& tree = tree_result.value();
+
+	std::vector<tes::formid_t> next_ids;
+	for (const auto& avif_perk : tree.avif_records.front().perks)
+	{
+		next_ids.emplace_back(avif_perk.record_id);
+	}
+
+	// Each round decodes the next rank of every perk found in the previous one.
+	while (!next_ids.empty())
+	{
+		auto perks_result = materialize_records(index, next_ids);
+		if (!perks_result.has_value())
+		{
+			return perks_result;
+		}
+		next_ids.clear();
+		for (const auto& perk_record : perks_result->perk_records)
+		{
+			if (const auto next_perk_id = perk_record.next_perk_id;
+					next_perk_id != tes::invalid_formid && !tree.parsed_record_ids.contains(next_perk_id) &&
+					!perks_result->parsed_record_ids.contains(next_perk_id))
+			{
+				next_ids.emplace_back(next_perk_id);
+			}
+		}
+		append_records(std::move(perks_result.value()), tree);
+	}
+
+	return tree_result;
+}
+
+}
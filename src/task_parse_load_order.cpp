@@ -1,4 +1,5 @@
 #include <josk/cli.hpp>
+#include <josk/stats.hpp>
 #include <josk/tasks.hpp>
 
 #include <expected>
@@ -14,6 +15,7 @@ namespace josk::task
 
 std::expected<plugins_to_load_t, std::string> parse_load_order(cli::arguments_t arguments)
 {
+	const stats::stage_timer timer{"parse_load_order"};
 	const auto load_order_path = arguments.profile_path / "loadorder.txt";
 	if (!std::filesystem::is_regular_file(load_order_path))
 	{
@@ -28,6 +30,7 @@ std::expected<plugins_to_load_t, std::string> parse_load_order(cli::arguments_t
 	plugins_to_load_t plugins_to_load;
 	plugins_to_load.data_path = std::move(arguments.data_path);
 	plugins_to_load.mods_path = std::move(arguments.mods_path);
+	plugins_to_load.hash_contents = arguments.dedupe_plugins;
 
 	auto& load_order = plugins_to_load.load_order;
 	order_t order{};
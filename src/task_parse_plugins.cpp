@@ -1,31 +1,624 @@
+#include <josk/arena.hpp>
+#include <josk/formid_table.hpp>
+#include <josk/io.hpp>
+#include <josk/stats.hpp>
 #include <josk/tasks.hpp>
 #include <josk/tes_parse.hpp>
+#include <josk/trace.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <expected>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <ranges>
+#include <set>
+#include <span>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
-namespace josk::task
+namespace
+{
+
+using namespace josk::task;
+using josk::stats::retained_bytes;
+
+/** Plugin files are read from disk in batches of this size, to bound the amount of memory held by their buffers. */
+constexpr std::size_t plugins_per_read_batch = 32Z;
+/** Initial amount of slots of the formid winner table. It grows when needed. */
+constexpr std::size_t winner_table_capacity = 1Z << 16U;
+
+/** Parts of a plugin loaded into memory. */
+struct plugin_load_t final
+{
+	josk::tes::plugin_data_t data;
+	/** Size of the whole plugin file. */
+	std::uint64_t file_size{};
+	/** Top groups which were not loaded, because they cannot contain any of the requested record types. */
+	std::uint64_t skipped_groups{};
+};
+
+using plugin_load_result_t = std::expected<plugin_load_t, std::string>;
+
+/**
+ * Reads the parts of a batch of plugins required by the parse options. The layout of each plugin is scanned first,
+ * and only its TES4 record and the top groups which may contain requested record types are read. Plugins without
+ * any of them are not read at all.
+ * @param plugins Plugins of the batch.
+ * @param options Parse options.
+ * @param io_backend I/O backend.
+ * @return Loaded data of each plugin, or an error.
+ */
+std::vector<plugin_load_result_t> load_plugins(
+		const std::span<const std::reference_wrapper<const plugin_t>> plugins, const josk::tes::parse_options_t& options,
+		const josk::io::backend_t io_backend
+)
+{
+	std::vector<plugin_load_result_t> loads;
+	std::vector<josk::io::read_request_t> read_requests;
+	// Index of the first read request of each plugin. The last entry marks the end of the requests.
+	std::vector<std::size_t> first_requests;
+	for (const auto& plugin : plugins)
+	{
+		first_requests.emplace_back(read_requests.size());
+		auto layout = josk::tes::scan_plugin_layout(plugin.get().path);
+		if (!layout.has_value())
+		{
+			loads.emplace_back(std::unexpected(std::move(layout.error())));
+			continue;
+		}
+
+		auto& load = loads.emplace_back(plugin_load_t{});
+		read_requests.emplace_back(plugin.get().path, 0U, layout->header_size);
+		load->file_size = layout->header_size;
+		for (const auto& [label_type, offset, size] : layout->groups)
+		{
+			load->file_size = offset + size;
+			if ((josk::tes::group_record_types(josk::tes::group_type_t::top, label_type) & options.record_types).none())
+			{
+				++load->skipped_groups;
+				continue;
+			}
+			// Contiguous groups are read with a single request.
+			if (auto& last = read_requests.back(); last.offset + last.size == offset)
+			{
+				last.size += size;
+			}
+			else
+			{
+				read_requests.emplace_back(plugin.get().path, offset, size);
+			}
+		}
+		if (load->skipped_groups == layout->groups.size() && !layout->groups.empty())
+		{
+			// Plugins without any required group are pruned, and their TES4 record is not read either.
+			read_requests.pop_back();
+		}
+	}
+	first_requests.emplace_back(read_requests.size());
+
+	auto buffers = josk::io::read(read_requests, io_backend);
+	for (std::size_t plugin_index{}; plugin_index < loads.size(); ++plugin_index)
+	{
+		auto& load = loads[plugin_index];
+		const auto first_request = first_requests[plugin_index];
+		const auto last_request = first_requests[plugin_index + 1Z];
+		if (!load.has_value() || first_request == last_request)
+		{
+			continue;
+		}
+		auto& [buffer, segments] = load->data;
+		for (auto request_index = first_request; request_index < last_request; ++request_index)
+		{
+			auto& request_buffer = buffers[request_index];
+			if (!request_buffer.has_value())
+			{
+				load = std::unexpected(std::move(request_buffer.error()));
+				break;
+			}
+			if (request_index == first_request)
+			{
+				buffer = std::move(request_buffer.value());
+				continue;
+			}
+			segments.emplace_back(buffer.size(), read_requests[request_index].offset);
+			buffer.insert(buffer.end(), request_buffer->cbegin(), request_buffer->cend());
+		}
+		if (load.has_value() && !segments.empty())
+		{
+			// The TES4 record is always at the start of both the buffer and the file.
+			segments.insert(segments.begin(), josk::tes::plugin_segment_t{});
+		}
+	}
+	return loads;
+}
+
+std::expected<void, std::string> parse_single_plugin(
+		const plugin_t& plugin, plugin_load_result_t load, josk::tes::parsed_records_t& records,
+		josk::tes::formid_winner_table& winners, josk::memory::arena_t& arena, const josk::tes::parse_options_t& options,
+		josk::stats::plugin_stats_t* stats
+)
 {
+	if (!load.has_value())
+	{
+		return std::unexpected(std::move(load.error()));
+	}
+	const josk::trace::scope trace_scope{"plugin", plugin.filename};
+	josk::stats::steady_clock_t::time_point start{};
+	if constexpr (josk::stats::enabled)
+	{
+		start = josk::stats::steady_clock_t::now();
+		stats->filename = plugin.filename;
+		stats->file_bytes = load->file_size;
+		stats->bytes_read = load->data.buffer.size();
+		stats->groups_skipped = load->skipped_groups;
+	}
+	const auto heap_allocations_before = arena.heap_allocations();
+	if (load->data.buffer.empty())
+	{
+		// Pruned plugin.
+		return {};
+	}
+	auto result = josk::tes::open_plugin(
+										plugin.path, plugin.filename, plugin.order, std::move(load->data), records, winners,
+										arena.resource(), options, stats
+	)
+										.and_then(josk::tes::parse_plugin)
+										.and_then(josk::tes::close_plugin);
+	// The parser has been destroyed at this point, and all of its transient allocations can be dropped at once.
+	arena.reset();
+	if constexpr (josk::stats::enabled)
+	{
+		stats->parse_time = josk::stats::steady_clock_t::now() - start;
+		stats->heap_fallbacks = arena.heap_allocations() - heap_allocations_before;
+	}
+	return result;
+}
+
+/** Records accepted by each plugin, before applying load order rules. */
+struct plugin_parse_results_t final
+{
+	/** Plugins sorted by inverse load order. */
+	std::vector<std::reference_wrapper<const plugin_t>> plugins;
+	/** Records of each plugin, in the same order. */
+	std::vector<josk::tes::parsed_records_t> plugin_records;
+	/** Statistics of each plugin, in the same order. Empty if statistics are disabled. */
+	std::vector<josk::stats::plugin_stats_t> plugin_stats;
+	/** Plugins left out because a plugin with higher priority has the same contents, sorted by load order. */
+	std::vector<plugin_t> duplicate_plugins;
+	josk::tes::formid_winner_table winners{winner_table_capacity};
+};
 
-std::expected<tes::parsed_records_t, std::string> parse_plugins(const std::vector<plugin_t>& plugins)
+/**
+ * Adds the statistics of each plugin to the report, in load order.
+ * @param results Plugin parse results.
+ */
+void report_plugin_stats(plugin_parse_results_t& results)
 {
-	tes::parsed_records_t parsed_records{};
-	// Files are read in inverse priority order. The first record we find with a specific formid is always the one that
-	// must be kept.
+	if constexpr (josk::stats::enabled)
+	{
+		std::ranges::reverse(results.plugin_stats);
+		// Duplicates are listed as skipped, at their place in the load order.
+		for (std::size_t inserted{}; const auto& plugin : results.duplicate_plugins)
+		{
+			const auto parsed_before = std::ranges::count_if(
+					results.plugins, [&plugin](const plugin_t& parsed) { return parsed.order < plugin.order; }
+			);
+			results.plugin_stats.insert(
+					results.plugin_stats.begin() + parsed_before + static_cast<std::ptrdiff_t>(inserted++),
+					{.filename = plugin.filename, .file_bytes = plugin.size, .skipped_duplicate = true}
+			);
+		}
+		josk::stats::add_plugins(std::move(results.plugin_stats));
+	}
+}
+
+/** Plugins of a load order, split by whether their contents are also found in a plugin with higher priority. */
+struct unique_plugins_t final
+{
+	/** Plugins which must be parsed, sorted by load order. */
+	std::vector<plugin_t> unique;
+	/** Plugins byte-identical to a plugin with higher priority, sorted by load order. */
+	std::vector<plugin_t> duplicates;
+};
+
+/**
+ * Finds plugins which are byte-identical to a plugin with higher priority. Every record they contain is overridden by
+ * the same version in that plugin, so parsing them cannot change the result.
+ * @param plugins Plugins sorted by load order. Only plugins with a content hash are compared.
+ * @return Plugins to parse and duplicates to skip.
+ */
+unique_plugins_t find_duplicate_plugins(const std::vector<plugin_t>& plugins)
+{
+	unique_plugins_t result;
+	result.unique.reserve(plugins.size());
+	std::set<std::pair<std::uint64_t, std::uint64_t>> contents;
 	for (const auto& plugin : plugins | std::views::reverse)
 	{
-		const auto plugin_result = tes::open_plugin(plugin.path, plugin.filename, parsed_records)
-																	 .and_then(tes::parse_plugin)
-																	 .and_then(tes::close_plugin);
+		if (plugin.content_hash == 0U || contents.emplace(plugin.size, plugin.content_hash).second)
+		{
+			result.unique.emplace_back(plugin);
+		}
+		else
+		{
+			result.duplicates.emplace_back(plugin);
+		}
+	}
+	std::ranges::reverse(result.unique);
+	std::ranges::reverse(result.duplicates);
+	return result;
+}
+
+/**
+ * Parses every plugin on its own. Plugins are parsed concurrently, and the winner table decides which version of each
+ * record must be kept. Processing plugins in inverse priority order lets lower priority plugins skip records that
+ * were already claimed.
+ * @param plugins Plugins sorted by load order.
+ * @param options Parse options.
+ * @param arenas Arenas of the workers. If empty, arenas are created for this call.
+ * @return Records of each plugin, or the first error found.
+ */
+std::expected<plugin_parse_results_t, std::string> parse_each_plugin(
+		const std::vector<plugin_t>& plugins, const josk::tes::parse_options_t& options,
+		std::span<josk::memory::arena_t> arenas = {}
+)
+{
+	plugin_parse_results_t results{};
+	results.plugins.assign(plugins.crbegin(), plugins.crend());
+	const auto plugin_count = plugins.size();
+	const auto io_backend = josk::io::available_backend();
+
+	// Each worker owns an arena, reused by all plugins it parses.
+	std::unique_ptr<josk::memory::arena_t[]> owned_arenas;
+	if (arenas.empty())
+	{
+		const auto arena_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1Z);
+		owned_arenas = std::make_unique<josk::memory::arena_t[]>(arena_count);
+		arenas = std::span{owned_arenas.get(), arena_count};
+	}
+	const auto worker_count = arenas.size();
+	results.plugin_records.resize(plugin_count);
+	if constexpr (josk::stats::enabled)
+	{
+		results.plugin_stats.resize(plugin_count);
+	}
+	std::vector<std::expected<void, std::string>> plugin_results(plugin_count);
+
+	const auto read_batch = [&results, &options, plugin_count, io_backend](const std::size_t batch_begin)
+	{
+		const josk::trace::scope trace_scope{"io", "read_batch"};
+		const auto batch_end = std::min(batch_begin + plugins_per_read_batch, plugin_count);
+		return load_plugins(
+				std::span{results.plugins}.subspan(batch_begin, batch_end - batch_begin), options, io_backend
+		);
+	};
+
+	// The next batch is read from disk while the current one is being parsed.
+	auto next_loads = std::async(std::launch::async, read_batch, std::size_t{});
+	for (std::size_t batch_begin{}; batch_begin < plugin_count; batch_begin += plugins_per_read_batch)
+	{
+		auto loads = next_loads.get();
+		const auto batch_end = std::min(batch_begin + plugins_per_read_batch, plugin_count);
+		if (batch_end < plugin_count)
+		{
+			next_loads = std::async(std::launch::async, read_batch, batch_end);
+		}
+
+		std::atomic<std::size_t> next_index{batch_begin};
+		const auto parse_worker = [&](josk::memory::arena_t& arena)
+		{
+			for (auto index = next_index.fetch_add(1Z); index < batch_end; index = next_index.fetch_add(1Z))
+			{
+				auto* stats = josk::stats::enabled ? &results.plugin_stats[index] : nullptr;
+				plugin_results[index] = parse_single_plugin(
+						results.plugins[index], std::move(loads[index - batch_begin]), results.plugin_records[index],
+						results.winners, arena, options, stats
+				);
+			}
+		};
+
+		std::vector<std::jthread> workers;
+		for (std::size_t worker{}; worker < std::min(worker_count, batch_end - batch_begin); ++worker)
+		{
+			workers.emplace_back([&parse_worker, &arena = arenas[worker]] { parse_worker(arena); });
+		}
+	}
+
+	// Errors are reported in the same order that a sequential parse would have found them.
+	for (const auto& plugin_result : plugin_results)
+	{
 		if (!plugin_result.has_value())
 		{
 			return std::unexpected(plugin_result.error());
 		}
 	}
 
+	return results;
+}
+
+/**
+ * Moves the winning version of each record into a single data structure.
+ * @param results Records accepted by each plugin.
+ * @return Parsed records following load order rules.
+ */
+josk::tes::parsed_records_t merge_winners(plugin_parse_results_t results)
+{
+	josk::tes::parsed_records_t parsed_records{};
+	for (std::size_t index{}; index < results.plugins.size(); ++index)
+	{
+		auto& records = results.plugin_records[index];
+		const auto is_winner = [&winners = results.winners, order = results.plugins[index].get().order](const auto& record)
+		{ return winners.winner(record.record_id) == order; };
+		const auto winner_count_before = parsed_records.parsed_record_ids.size();
+		for (auto& avif_record : records.avif_records | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(avif_record.record_id);
+			parsed_records.avif_records.emplace_back(std::move(avif_record));
+		}
+		for (auto& perk_record : records.perk_records | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(perk_record.record_id);
+			parsed_records.perk_records.emplace_back(std::move(perk_record));
+		}
+		for (auto& leveled_list : records.leveled_list_records | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(leveled_list.record_id);
+			parsed_records.leveled_list_records.emplace_back(std::move(leveled_list));
+		}
+		for (auto& cobj_record : records.cobj_records | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(cobj_record.record_id);
+			parsed_records.cobj_records.emplace_back(std::move(cobj_record));
+		}
+		for (const auto& reference : records.placed_references | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(reference.record_id);
+			parsed_records.placed_references.emplace_back(reference);
+		}
+		for (auto& dial_record : records.dial_records | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(dial_record.record_id);
+			parsed_records.dial_records.emplace_back(std::move(dial_record));
+		}
+		for (auto& info_record : records.info_records | std::views::filter(is_winner))
+		{
+			parsed_records.parsed_record_ids.emplace(info_record.record_id);
+			parsed_records.info_records.emplace_back(std::move(info_record));
+		}
+		if constexpr (josk::stats::enabled)
+		{
+			// Records decoded by this plugin which lost against a plugin with higher priority that claimed them later.
+			auto& stats = results.plugin_stats[index];
+			stats.records_accepted = parsed_records.parsed_record_ids.size() - winner_count_before;
+			stats.records_overridden += records.parsed_record_ids.size() - stats.records_accepted;
+		}
+		records = {};
+	}
+	report_plugin_stats(results);
+	return parsed_records;
+}
+
+/**
+ * Adds the memory retained by the parsed records to the statistics report.
+ * @param parsed_records Parsed records following load order rules.
+ * @return The same parsed records.
+ */
+josk::tes::parsed_records_t report_retained_memory(josk::tes::parsed_records_t parsed_records)
+{
+	if constexpr (josk::stats::enabled)
+	{
+		auto avif_bytes = retained_bytes(parsed_records.avif_records);
+		for (const auto& avif_record : parsed_records.avif_records)
+		{
+			avif_bytes += retained_bytes(avif_record.name) + retained_bytes(avif_record.description) +
+										retained_bytes(avif_record.perks);
+		}
+		josk::stats::add_container({"avif_records", parsed_records.avif_records.size(), avif_bytes});
+
+		auto perk_bytes = retained_bytes(parsed_records.perk_records);
+		for (const auto& perk_record : parsed_records.perk_records)
+		{
+			perk_bytes += retained_bytes(perk_record.name) + retained_bytes(perk_record.description) +
+										retained_bytes(perk_record.prereq_perk_ids) + retained_bytes(perk_record.conditions.conditions) +
+										retained_bytes(perk_record.conditions.strings);
+			for (const auto& condition_string : perk_record.conditions.strings)
+			{
+				perk_bytes += retained_bytes(condition_string);
+			}
+		}
+		josk::stats::add_container({"perk_records", parsed_records.perk_records.size(), perk_bytes});
+
+		auto leveled_list_bytes = retained_bytes(parsed_records.leveled_list_records);
+		for (const auto& leveled_list : parsed_records.leveled_list_records)
+		{
+			leveled_list_bytes += retained_bytes(leveled_list.entries);
+		}
+		josk::stats::add_container(
+				{"leveled_list_records", parsed_records.leveled_list_records.size(), leveled_list_bytes}
+		);
+
+		auto cobj_bytes = retained_bytes(parsed_records.cobj_records);
+		for (const auto& cobj_record : parsed_records.cobj_records)
+		{
+			cobj_bytes += retained_bytes(cobj_record.components) + retained_bytes(cobj_record.conditions.conditions) +
+										retained_bytes(cobj_record.conditions.strings);
+			for (const auto& condition_string : cobj_record.conditions.strings)
+			{
+				cobj_bytes += retained_bytes(condition_string);
+			}
+		}
+		josk::stats::add_container({"cobj_records", parsed_records.cobj_records.size(), cobj_bytes});
+
+		const auto& references = parsed_records.placed_references;
+		josk::stats::add_container({"placed_references", references.size(), retained_bytes(references)});
+
+		auto dial_bytes = retained_bytes(parsed_records.dial_records);
+		for (const auto& dial_record : parsed_records.dial_records)
+		{
+			dial_bytes += retained_bytes(dial_record.name);
+		}
+		josk::stats::add_container({"dial_records", parsed_records.dial_records.size(), dial_bytes});
+
+		auto info_bytes = retained_bytes(parsed_records.info_records);
+		for (const auto& info_record : parsed_records.info_records)
+		{
+			info_bytes += retained_bytes(info_record.prompt) + retained_bytes(info_record.responses) +
+										retained_bytes(info_record.conditions.conditions) +
+										retained_bytes(info_record.conditions.strings);
+			for (const auto& response : info_record.responses)
+			{
+				info_bytes += retained_bytes(response.text);
+			}
+			for (const auto& condition_string : info_record.conditions.strings)
+			{
+				info_bytes += retained_bytes(condition_string);
+			}
+		}
+		josk::stats::add_container({"info_records", parsed_records.info_records.size(), info_bytes});
+
+		// Estimation assuming one bucket pointer per bucket, and nodes with a value and two pointers.
+		const auto& record_ids = parsed_records.parsed_record_ids;
+		constexpr auto node_size = sizeof(josk::tes::formid_t) + (2Z * sizeof(void*));
+		const auto record_ids_bytes = (record_ids.bucket_count() * sizeof(void*)) + (record_ids.size() * node_size);
+		josk::stats::add_container({"parsed_record_ids", record_ids.size(), record_ids_bytes});
+	}
 	return parsed_records;
 }
 
+/**
+ * Gathers the handles found by each plugin into a record index.
+ * @param plugins Plugins sorted by load order.
+ * @param results Handles found in each plugin.
+ * @return Record index.
+ */
+record_index_t merge_handles(std::vector<plugin_t> plugins, plugin_parse_results_t results)
+{
+	record_index_t index{};
+	for (auto& records : results.plugin_records)
+	{
+		index.handles.insert(index.handles.end(), records.record_handles.cbegin(), records.record_handles.cend());
+		records = {};
+	}
+	report_plugin_stats(results);
+	std::ranges::sort(
+			index.handles,
+			[](const josk::tes::record_handle_t& lhs, const josk::tes::record_handle_t& rhs)
+			{ return lhs.record_id < rhs.record_id || (lhs.record_id == rhs.record_id && lhs.priority > rhs.priority); }
+	);
+	index.plugins = std::move(plugins);
+	if constexpr (josk::stats::enabled)
+	{
+		josk::stats::add_container({"record_handles", index.handles.size(), retained_bytes(index.handles)});
+	}
+	return index;
+}
+
+}
+
+namespace josk::task
+{
+
+std::expected<tes::parsed_records_t, std::string> parse_plugins(
+		const std::vector<plugin_t>& plugins, const tes::record_type_set_t record_types
+)
+{
+	const stats::stage_timer timer{"parse_plugins"};
+	const tes::parse_options_t options{.mode = tes::parse_mode_t::decode, .record_types = record_types};
+	// Parse results refer to these plugins until they are merged.
+	auto [unique_plugins, duplicate_plugins] = find_duplicate_plugins(plugins);
+	auto results = parse_each_plugin(unique_plugins, options);
+	if (!results.has_value())
+	{
+		return std::unexpected(std::move(results.error()));
+	}
+	results->duplicate_plugins = std::move(duplicate_plugins);
+	return report_retained_memory(merge_winners(std::move(results.value())));
+}
+
+std::expected<std::vector<tes::parsed_records_t>, std::string> parse_plugins_separately(
+		const std::vector<plugin_t>& plugins, const tes::record_type_set_t record_types,
+		const std::span<memory::arena_t> arenas
+)
+{
+	const stats::stage_timer timer{"parse_plugins_separately"};
+	const tes::parse_options_t options{
+			.mode = tes::parse_mode_t::decode, .record_types = record_types, .skip_claimed = false
+	};
+
+	// Only the first of each group of byte-identical plugins is parsed. The rest receive a copy of its records.
+	std::vector<plugin_t> unique_plugins;
+	std::vector<std::size_t> unique_positions;
+	unique_positions.reserve(plugins.size());
+	std::map<std::pair<std::uint64_t, std::uint64_t>, std::size_t> content_positions;
+	for (const auto& plugin : plugins)
+	{
+		if (plugin.content_hash != 0U)
+		{
+			const auto [itr, inserted] =
+					content_positions.try_emplace({plugin.size, plugin.content_hash}, unique_plugins.size());
+			if (!inserted)
+			{
+				unique_positions.emplace_back(itr->second);
+				continue;
+			}
+		}
+		unique_positions.emplace_back(unique_plugins.size());
+		unique_plugins.emplace_back(plugin);
+	}
+
+	auto results = parse_each_plugin(unique_plugins, options, arenas);
+	if (!results.has_value())
+	{
+		return std::unexpected(std::move(results.error()));
+	}
+	// Plugins were parsed in inverse load order.
+	auto unique_records = std::move(results->plugin_records);
+	std::ranges::reverse(unique_records);
+	report_plugin_stats(results.value());
+	if (unique_plugins.size() == plugins.size())
+	{
+		return unique_records;
+	}
+
+	std::vector<std::size_t> remaining_uses(unique_records.size());
+	for (const auto position : unique_positions)
+	{
+		++remaining_uses[position];
+	}
+	std::vector<tes::parsed_records_t> plugin_records;
+	plugin_records.reserve(plugins.size());
+	for (const auto position : unique_positions)
+	{
+		if (--remaining_uses[position] == 0Z)
+		{
+			plugin_records.emplace_back(std::move(unique_records[position]));
+		}
+		else
+		{
+			plugin_records.emplace_back(unique_records[position]);
+		}
+	}
+	return plugin_records;
+}
+
+std::expected<record_index_t, std::string> index_plugins(
+		std::vector<plugin_t> plugins, const tes::record_type_set_t record_types
+)
+{
+	const stats::stage_timer timer{"index_plugins"};
+	const tes::parse_options_t options{.mode = tes::parse_mode_t::index, .record_types = record_types};
+	auto results = parse_each_plugin(plugins, options);
+	if (!results.has_value())
+	{
+		return std::unexpected(std::move(results.error()));
+	}
+	return merge_handles(std::move(plugins), std::move(results.value()));
+}
+
 }
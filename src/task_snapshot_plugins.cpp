@@ -0,0 +1,302 @@
+#include <josk/io.hpp>
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using namespace josk::task;
+
+/** Plugin files are hashed in batches of this size, to bound the amount of memory held by their buffers. */
+constexpr std::size_t plugins_per_hash_batch = 32Z;
+
+/** Identifies snapshot files, and the version of their format. */
+constexpr std::string_view snapshot_magic{"JOSKSNP1"};
+
+/** Size and content hash of a plugin. Plugins with the same key are considered identical. */
+using plugin_key_t = std::pair<std::uint64_t, std::uint64_t>;
+
+template <typename Value>
+void append_value(std::string& output, const Value value)
+{
+	const auto bytes = std::bit_cast<std::array<char, sizeof(Value)>>(value);
+	output.append(bytes.data(), bytes.size());
+}
+
+/** Reads values from the contents of a snapshot file. Reads past its end return zero and invalidate the reader. */
+class snapshot_reader final
+{
+	std::span<const char> _data;
+	std::size_t _position{};
+	bool _valid{true};
+
+	std::span<const char> read_bytes(const std::size_t size)
+	{
+		if (!_valid || _data.size() - _position < size)
+		{
+			_valid = false;
+			return {};
+		}
+		const auto bytes = _data.subspan(_position, size);
+		_position += size;
+		return bytes;
+	}
+
+public:
+	explicit snapshot_reader(const std::span<const char> data) noexcept
+		: _data{data}
+	{
+	}
+
+	template <typename Value>
+	Value read()
+	{
+		std::array<char, sizeof(Value)> bytes{};
+		if (const auto data = read_bytes(bytes.size()); !data.empty())
+		{
+			std::ranges::copy(data, bytes.begin());
+		}
+		return std::bit_cast<Value>(bytes);
+	}
+
+	std::string_view read_string(const std::size_t size)
+	{
+		const auto data = read_bytes(size);
+		return {data.data(), data.size()};
+	}
+
+	/** Counts stored in the file must fit in the remaining data, with elements of at least this size. */
+	std::uint32_t read_count(const std::size_t element_size)
+	{
+		const auto count = read<std::uint32_t>();
+		if (_valid && (_data.size() - _position) / element_size < count)
+		{
+			_valid = false;
+			return 0U;
+		}
+		return count;
+	}
+
+	[[nodiscard]] bool valid() const noexcept
+	{
+		return _valid;
+	}
+
+	[[nodiscard]] bool at_end() const noexcept
+	{
+		return _position == _data.size();
+	}
+};
+
+/** Size of a handle in a snapshot file: formid, record type and fingerprint. */
+constexpr std::size_t saved_handle_size =
+		sizeof(josk::tes::formid_t) + sizeof(std::uint16_t) + sizeof(josk::tes::fingerprint_t);
+
+}
+
+namespace josk::task
+{
+
+std::expected<modlist_snapshot_t, std::string> snapshot_plugins(
+		const std::vector<plugin_t>& plugins, const tes::record_type_set_t record_types, const modlist_snapshot_t* reusable
+)
+{
+	const stats::stage_timer timer{"snapshot_plugins"};
+	std::map<plugin_key_t, const plugin_snapshot_t*> reusable_plugins;
+	if (reusable != nullptr)
+	{
+		if (reusable->record_types != record_types)
+		{
+			return std::unexpected("Snapshots of different record types cannot be reused.");
+		}
+		for (const auto& plugin : reusable->plugins)
+		{
+			reusable_plugins.emplace(plugin_key_t{plugin.size, plugin.content_hash}, &plugin);
+		}
+	}
+
+	modlist_snapshot_t snapshot{.record_types = record_types, .plugins = std::vector<plugin_snapshot_t>(plugins.size())};
+	// Plugins which must be indexed. Their order is their position in the snapshot.
+	std::vector<plugin_t> changed_plugins;
+	const auto io_backend = io::available_backend();
+	for (std::size_t batch_begin{}; batch_begin < plugins.size(); batch_begin += plugins_per_hash_batch)
+	{
+		const auto batch_end = std::min(batch_begin + plugins_per_hash_batch, plugins.size());
+		std::vector<io::read_request_t> read_requests;
+		for (auto position = batch_begin; position < batch_end; ++position)
+		{
+			read_requests.emplace_back(plugins[position].path);
+		}
+		const auto buffers = io::read(read_requests, io_backend);
+		for (auto position = batch_begin; position < batch_end; ++position)
+		{
+			const auto& buffer = buffers[position - batch_begin];
+			if (!buffer.has_value())
+			{
+				return std::unexpected(buffer.error());
+			}
+			auto& plugin_snapshot = snapshot.plugins[position];
+			plugin_snapshot.filename = plugins[position].filename;
+			plugin_snapshot.size = buffer->size();
+			plugin_snapshot.content_hash = io::hash_bytes(buffer.value(), 0U);
+
+			const auto itr = reusable_plugins.find(plugin_key_t{plugin_snapshot.size, plugin_snapshot.content_hash});
+			if (itr == reusable_plugins.cend())
+			{
+				const auto& plugin = plugins[position];
+				changed_plugins.emplace_back(static_cast<order_t>(position), plugin.filename, plugin.path);
+				continue;
+			}
+			// Byte-identical plugins are not parsed again.
+			plugin_snapshot.handles = itr->second->handles;
+			for (auto& handle : plugin_snapshot.handles)
+			{
+				handle.priority = static_cast<tes::priority_t>(position);
+			}
+		}
+	}
+
+	if (!changed_plugins.empty())
+	{
+		auto index = index_plugins(std::move(changed_plugins), record_types);
+		if (!index.has_value())
+		{
+			return std::unexpected(std::move(index.error()));
+		}
+		for (const auto& handle : index->handles)
+		{
+			snapshot.plugins[static_cast<std::size_t>(handle.priority)].handles.emplace_back(handle);
+		}
+	}
+
+	if constexpr (stats::enabled)
+	{
+		std::size_t handle_count{};
+		std::uint64_t handle_bytes{};
+		for (const auto& plugin : snapshot.plugins)
+		{
+			handle_count += plugin.handles.size();
+			handle_bytes += stats::retained_bytes(plugin.handles);
+		}
+		stats::add_container({"snapshot_handles", handle_count, handle_bytes});
+	}
+	return snapshot;
+}
+
+std::expected<modlist_snapshot_t, std::string> read_snapshot(const std::filesystem::path& path)
+{
+	const stats::stage_timer timer{"read_snapshot"};
+	const std::array read_requests{io::read_request_t{path}};
+	auto buffers = io::read(read_requests, io::available_backend());
+	if (!buffers.front().has_value())
+	{
+		return std::unexpected(std::move(buffers.front().error()));
+	}
+
+	snapshot_reader reader{buffers.front().value()};
+	const auto invalid_snapshot = [&path]
+	{ return std::unexpected(std::format("Invalid snapshot file {}.", path.generic_string())); };
+	if (reader.read_string(snapshot_magic.size()) != snapshot_magic)
+	{
+		return invalid_snapshot();
+	}
+
+	modlist_snapshot_t snapshot{};
+	const auto record_type_count = reader.read_count(tes::section_id_byte_size);
+	for (std::uint32_t index{}; index < record_type_count; ++index)
+	{
+		const auto record_type = tes::to_record_type(reader.read_string(tes::section_id_byte_size));
+		if (record_type == tes::record_type_t::none)
+		{
+			return invalid_snapshot();
+		}
+		snapshot.record_types |= tes::to_record_type_set(record_type);
+	}
+
+	constexpr std::size_t min_plugin_size = sizeof(std::uint32_t) * 2Z + sizeof(std::uint64_t) * 2Z;
+	snapshot.plugins.resize(reader.read_count(min_plugin_size));
+	for (std::size_t position{}; position < snapshot.plugins.size(); ++position)
+	{
+		auto& plugin = snapshot.plugins[position];
+		plugin.filename = reader.read_string(reader.read_count(1Z));
+		plugin.size = reader.read<std::uint64_t>();
+		plugin.content_hash = reader.read<std::uint64_t>();
+		plugin.handles.resize(reader.read_count(saved_handle_size));
+		for (auto& handle : plugin.handles)
+		{
+			handle.record_id = reader.read<tes::formid_t>();
+			const auto record_type = reader.read<std::uint16_t>();
+			if (record_type >= static_cast<std::uint16_t>(tes::record_type_t::none))
+			{
+				return invalid_snapshot();
+			}
+			handle.record_type = static_cast<tes::record_type_t>(record_type);
+			handle.priority = static_cast<tes::priority_t>(position);
+			handle.fingerprint = reader.read<tes::fingerprint_t>();
+		}
+	}
+	if (!reader.valid() || !reader.at_end())
+	{
+		return invalid_snapshot();
+	}
+	return snapshot;
+}
+
+std::expected<void, std::string> write_snapshot(const modlist_snapshot_t& snapshot, const std::filesystem::path& path)
+{
+	const stats::stage_timer timer{"write_snapshot"};
+	std::string output{snapshot_magic};
+	append_value(output, static_cast<std::uint32_t>(snapshot.record_types.count()));
+	for (std::size_t record_type{}; record_type < snapshot.record_types.size(); ++record_type)
+	{
+		if (snapshot.record_types.test(record_type))
+		{
+			output.append(tes::to_record_string(static_cast<tes::record_type_t>(record_type)));
+		}
+	}
+
+	append_value(output, static_cast<std::uint32_t>(snapshot.plugins.size()));
+	for (const auto& plugin : snapshot.plugins)
+	{
+		append_value(output, static_cast<std::uint32_t>(plugin.filename.size()));
+		output.append(plugin.filename);
+		append_value(output, plugin.size);
+		append_value(output, plugin.content_hash);
+		append_value(output, static_cast<std::uint32_t>(plugin.handles.size()));
+		for (const auto& handle : plugin.handles)
+		{
+			append_value(output, handle.record_id);
+			append_value(output, static_cast<std::uint16_t>(handle.record_type));
+			append_value(output, handle.fingerprint);
+		}
+	}
+
+	std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+	file.write(output.data(), static_cast<std::streamsize>(output.size()));
+	if (!file.good())
+	{
+		return std::unexpected(std::format("Could not write snapshot file {}.", path.generic_string()));
+	}
+	return {};
+}
+
+}
@@ -0,0 +1,335 @@
+#include <josk/json.hpp>
+#include <josk/record_json.hpp>
+#include <josk/stats.hpp>
+#include <josk/tasks.hpp>
+#include <josk/tes_format.hpp>
+#include <josk/tes_parse.hpp>
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+/**
+ * Appends a skill tree, with the formids of the perks of each node and their ranks, and the nodes each one unlocks.
+ * @param output String receiving the tree.
+ * @param records Parsed records.
+ * @param perk_graph Perk graph of the parsed records.
+ * @param tree Skill tree.
+ */
+void append_perk_tree(
+		std::string& output, const josk::tes::parsed_records_t& records, const josk::task::perk_graph_t& perk_graph,
+		const josk::task::perk_tree_t& tree
+)
+{
+	using josk::task::invalid_record_position;
+
+	auto out = std::back_inserter(output);
+	std::format_to(out, "{{\"record_id\":{},\"nodes\":[", records.avif_records[tree.avif_position].record_id);
+	for (std::size_t node{}; node < tree.nodes.size(); ++node)
+	{
+		output.append(node == 0Z ? "{\"ranks\":[" : ",{\"ranks\":[");
+		// Broken plugins may contain rank cycles. No chain can be longer than the number of perks.
+		auto rank = tree.nodes[node];
+		for (std::size_t rank_count{}; rank != invalid_record_position && rank_count < records.perk_records.size();
+				 ++rank_count)
+		{
+			std::format_to(out, "{}{}", rank_count == 0Z ? "" : ",", records.perk_records[rank].record_id);
+			rank = perk_graph.next_ranks[rank];
+		}
+		output.append("],\"children\":[");
+		for (auto child = tree.child_offsets[node]; child < tree.child_offsets[node + 1Z]; ++child)
+		{
+			std::format_to(out, "{}{}", child == tree.child_offsets[node] ? "" : ",", tree.children[child]);
+		}
+		output.append("]}");
+	}
+	output.append("]}");
+}
+
+/**
+ * Appends a leveled list, with its entries and the expected amount of each record it generates at each level.
+ * @param output String receiving the leveled list.
+ * @param record Leveled list record.
+ * @param flat_list Flattened version of the leveled list.
+ */
+void append_leveled_list(
+		std::string& output, const josk::tes::leveled_list_record& record, const josk::task::flat_leveled_list_t& flat_list
+)
+{
+	auto out = std::back_inserter(output);
+	output.push_back('{');
+	josk::json::append_record_fields(output, record);
+	output.append(",\"levels\":[");
+	for (std::size_t distribution{}; distribution < flat_list.levels.size(); ++distribution)
+	{
+		const auto level = flat_list.levels[distribution];
+		std::format_to(out, "{}{{\"level\":{},\"items\":[", distribution == 0Z ? "" : ",", level);
+		for (bool first{true}; const auto& [record_id, count] : flat_list.at_level(level))
+		{
+			std::format_to(out, "{}{{\"record_id\":{},\"count\":{}}}", first ? "" : ",", record_id, count);
+			first = false;
+		}
+		output.append("]}");
+	}
+	output.append("]}");
+}
+
+/**
+ * Appends the formids of a range of records.
+ * @param output String receiving the formids.
+ * @param records Records referenced by the positions.
+ * @param positions Record positions.
+ */
+template <typename Record>
+void append_record_ids(
+		std::string& output, const std::vector<Record>& records,
+		const std::span<const josk::task::record_position_t> positions
+)
+{
+	output.push_back('[');
+	for (bool first{true}; const auto position : positions)
+	{
+		std::format_to(std::back_inserter(output), "{}{}", first ? "" : ",", records[position].record_id);
+		first = false;
+	}
+	output.push_back(']');
+}
+
+/**
+ * Appends the override history of a record, with the plugins containing each of its versions.
+ * @param output String receiving the record.
+ * @param index Record index used to build the override report.
+ * @param overrides Override history of the record.
+ */
+void append_record_overrides(
+		std::string& output, const josk::task::record_index_t& index, const josk::task::record_overrides_t& overrides
+)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(
+			out, "{{\"record_id\":{},\"type\":\"{}\",\"identical_to_master\":{},\"lost_overrides\":{},\"plugins\":[",
+			overrides.record_id, josk::tes::to_record_string(overrides.record_type), overrides.identical_to_master,
+			overrides.lost_overrides
+	);
+	// Versions start from the winning one.
+	const auto versions = std::span{index.handles}.subspan(overrides.first_handle, overrides.version_count);
+	for (bool first{true}; const auto& handle : versions)
+	{
+		output.append(first ? "" : ",");
+		const auto* plugin = index.find_plugin(handle);
+		josk::json::append_string(output, plugin != nullptr ? std::string_view{plugin->filename} : std::string_view{});
+		first = false;
+	}
+	output.append("]}");
+}
+
+/**
+ * Appends a key of an inverted index, with the formids of the records referencing it.
+ * @param output String receiving the key.
+ * @param records Records referenced by the index.
+ * @param index Inverted index containing the key.
+ * @param key_index Position of the key in the index.
+ * @param values_name Name given to the records referencing the key.
+ */
+template <typename Record>
+void append_index_key(
+		std::string& output, const std::vector<Record>& records, const josk::task::inverted_index_t& index,
+		const std::size_t key_index, const std::string_view values_name
+)
+{
+	const auto begin = index.offsets[key_index];
+	const auto values = std::span{index.values}.subspan(begin, index.offsets[key_index + 1Z] - begin);
+	std::format_to(std::back_inserter(output), "{{\"record_id\":{},\"{}\":", index.keys[key_index], values_name);
+	append_record_ids(output, records, values);
+	output.push_back('}');
+}
+
+/**
+ * Appends a dialogue topic, with the formids of its responses.
+ * @param output String receiving the topic.
+ * @param records Parsed records.
+ * @param topic_infos INFO records of each DIAL record.
+ * @param record DIAL record.
+ */
+void append_dial(
+		std::string& output, const josk::tes::parsed_records_t& records, const josk::task::inverted_index_t& topic_infos,
+		const josk::tes::dial_record& record
+)
+{
+	output.push_back('{');
+	josk::json::append_record_fields(output, record);
+	output.append(",\"infos\":");
+	append_record_ids(output, records.info_records, topic_infos.find(record.record_id));
+	output.push_back('}');
+}
+
+/**
+ * Appends the grid of a worldspace, with the formids of the references placed in each one of its cells.
+ * @param output String receiving the grid.
+ * @param records Parsed records.
+ * @param world Worldspace grid.
+ */
+void append_world_grid(
+		std::string& output, const josk::tes::parsed_records_t& records, const josk::task::world_grid_t& world
+)
+{
+	auto out = std::back_inserter(output);
+	std::format_to(out, "{{\"world_id\":{},\"cells\":[", world.world_id);
+	for (std::size_t cell{}; cell < world.cells.size(); ++cell)
+	{
+		const auto [x_pos, y_pos] = world.cells[cell];
+		std::format_to(out, "{}{{\"x\":{},\"y\":{},\"references\":", cell == 0Z ? "" : ",", x_pos, y_pos);
+		append_record_ids(output, records.placed_references, world.cell_references(world.cells[cell]));
+		output.push_back('}');
+	}
+	output.append("]}");
+}
+
+/** Appends a record on its own, without any of the data derived from it. */
+constexpr auto append_record_object = [](std::string& output, const auto& record)
+{ josk::json::append_record(output, record); };
+
+/**
+ * Writes a JSON array containing the provided records.
+ * @param path Path of the output file.
+ * @param records Records to write.
+ * @param append_record Appends the JSON representation of a single record.
+ * @return Nothing, or an error.
+ */
+template <typename Records, typename AppendRecord>
+std::expected<void, std::string> write_array(
+		const std::filesystem::path& path, const Records& records, AppendRecord append_record
+)
+{
+	std::string output{"["};
+	for (bool first{true}; const auto& record : records)
+	{
+		if (!first)
+		{
+			output.push_back(',');
+		}
+		output.append("\n");
+		append_record(output, record);
+		first = false;
+	}
+	output.append("\n]\n");
+
+	std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+	file.write(output.data(), static_cast<std::streamsize>(output.size()));
+	if (!file.good())
+	{
+		return std::unexpected(std::format("Could not write output file {}.", path.generic_string()));
+	}
+	return {};
+}
+
+}
+
+namespace josk::task
+{
+
+std::expected<void, std::string> write_output(const extracted_data_t& data, const std::filesystem::path& output_path)
+{
+	const stats::stage_timer timer{"write_output"};
+	const auto& records = data.records;
+	const auto append_tree = [&data](std::string& output, const perk_tree_t& tree)
+	{ append_perk_tree(output, data.records, data.perk_graph, tree); };
+	const auto append_list = [&data](std::string& output, const std::size_t position)
+	{ append_leveled_list(output, data.records.leveled_list_records[position], data.leveled_lists[position]); };
+	const auto write_index =
+			[&output_path](
+					const std::string_view filename, const auto& index_records, const inverted_index_t& index,
+					const std::string_view values_name
+			)
+	{
+		const auto append_key = [&index_records, &index, values_name](std::string& output, const std::size_t key_index)
+		{ append_index_key(output, index_records, index, key_index, values_name); };
+		return write_array(output_path / filename, std::views::iota(std::size_t{}, index.keys.size()), append_key);
+	};
+	const auto append_world = [&records](std::string& output, const world_grid_t& world)
+	{ append_world_grid(output, records, world); };
+	const auto append_topic = [&data](std::string& output, const tes::dial_record& record)
+	{ append_dial(output, data.records, data.topic_infos, record); };
+	return write_array(output_path / "avif.json", records.avif_records, append_record_object)
+			.and_then([&records, &output_path]
+								{ return write_array(output_path / "perk.json", records.perk_records, append_record_object); })
+			.and_then([&data, &output_path, &append_tree]
+								{ return write_array(output_path / "perk_tree.json", data.perk_graph.trees, append_tree); })
+			.and_then(
+					[&data, &output_path, &append_list]
+					{
+						const auto positions = std::views::iota(std::size_t{}, data.leveled_lists.size());
+						return write_array(output_path / "leveled_list.json", positions, append_list);
+					}
+			)
+			.and_then([&records, &output_path]
+								{ return write_array(output_path / "cobj.json", records.cobj_records, append_record_object); })
+			.and_then(
+					[&data, &write_index]
+					{
+						return write_index(
+								"recipes_by_created_object.json", data.records.cobj_records, data.recipe_index.created_objects,
+								"recipes"
+						);
+					}
+			)
+			.and_then(
+					[&data, &write_index]
+					{
+						return write_index(
+								"recipes_by_component.json", data.records.cobj_records, data.recipe_index.components, "recipes"
+						);
+					}
+			)
+			.and_then(
+					[&records, &output_path]
+					{
+						return write_array(
+								output_path / "placed_reference.json", records.placed_references, append_record_object
+						);
+					}
+			)
+			.and_then(
+					[&data, &output_path, &append_world]
+					{ return write_array(output_path / "world_grid.json", data.reference_grid.worlds, append_world); }
+			)
+			.and_then(
+					[&data, &write_index]
+					{
+						return write_index(
+								"interior_cell.json", data.records.placed_references, data.reference_grid.interior_cells,
+								"references"
+						);
+					}
+			)
+			.and_then([&records, &output_path, &append_topic]
+								{ return write_array(output_path / "dial.json", records.dial_records, append_topic); })
+			.and_then([&records, &output_path]
+								{ return write_array(output_path / "info.json", records.info_records, append_record_object); })
+			.and_then(
+					[&data, &output_path]() -> std::expected<void, std::string>
+					{
+						if (!data.override_report.has_value())
+						{
+							return {};
+						}
+						const auto& report = data.override_report.value();
+						const auto append_overrides = [&report](std::string& output, const record_overrides_t& overrides)
+						{ append_record_overrides(output, report.index, overrides); };
+						return write_array(output_path / "overrides.json", report.records, append_overrides);
+					}
+			);
+}
+
+}
@@ -18,7 +18,7 @@ record_type_t to_record_type(const std::string_view record_type_string) noexcept
 	}
 
 	const auto itr = std::ranges::lower_bound(record_type_str, record_type_string);
-	if (itr == record_type_str.cend())
+	if (itr == record_type_str.cend() || *itr != record_type_string)
 	{
 		return record_type_t::none;
 	}
@@ -26,6 +26,62 @@ record_type_t to_record_type(const std::string_view record_type_string) noexcept
 	return static_cast<record_type_t>(std::distance(record_type_str.cbegin(), itr));
 }
 
+field_type_t to_field_type(const std::string_view field_type_string) noexcept
+{
+	if (field_type_string.size() != section_id_byte_size)
+	{
+		return field_type_t::none;
+	}
+
+	const auto itr = std::ranges::lower_bound(field_type_str, field_type_string);
+	if (itr == field_type_str.cend() || *itr != field_type_string)
+	{
+		return field_type_t::none;
+	}
+
+	return static_cast<field_type_t>(std::distance(field_type_str.cbegin(), itr));
+}
+
+record_type_set_t group_record_types(const group_type_t group_type, const record_type_t label_type) noexcept
+{
+	// Records placed inside of cells. Pxxx placed projectiles are not known by josk.
+	const auto cell_children_types = to_record_type_set(record_type_t::achr) | to_record_type_set(record_type_t::land) |
+																	 to_record_type_set(record_type_t::navm) | to_record_type_set(record_type_t::pgre) |
+																	 to_record_type_set(record_type_t::phzd) | to_record_type_set(record_type_t::refr);
+	const auto cell_types = to_record_type_set(record_type_t::cell) | cell_children_types;
+
+	switch (group_type)
+	{
+		case group_type_t::top:
+			if (label_type == record_type_t::cell)
+			{
+				return cell_types;
+			}
+			if (label_type == record_type_t::dial)
+			{
+				return to_record_type_set(record_type_t::dial) | to_record_type_set(record_type_t::info);
+			}
+			if (label_type == record_type_t::wrld)
+			{
+				return to_record_type_set(record_type_t::wrld) | cell_types;
+			}
+			return to_record_type_set(label_type);
+		case group_type_t::world_children:
+		case group_type_t::interior_cell_block:
+		case group_type_t::interior_cell_sub_block:
+		case group_type_t::exterior_cell_block:
+		case group_type_t::exterior_cell_sub_block:
+			return cell_types;
+		case group_type_t::cell_children:
+		case group_type_t::cell_persistent_children:
+		case group_type_t::cell_temporary_children:
+			return cell_children_types;
+		case group_type_t::topic_children:
+			return to_record_type_set(record_type_t::info);
+	}
+	return {};
+}
+
 }
 
 namespace
@@ -170,7 +226,12 @@ static_assert(
 
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::anam)] == "ANAM");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::avsk)] == "AVSK");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::bnam)] == "BNAM");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::cis1)] == "CIS1");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::cis2)] == "CIS2");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::cnam)] == "CNAM");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::cnto)] == "CNTO");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::coct)] == "COCT");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::ctda)] == "CTDA");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::data)] == "DATA");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::desc)] == "DESC");
@@ -180,9 +241,18 @@ static_assert(field_type_str[static_cast<std::size_t>(field_type_t::full)] == "F
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::hnam)] == "HNAM");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::icon)] == "ICON");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::inam)] == "INAM");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::lvld)] == "LVLD");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::lvlf)] == "LVLF");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::lvlg)] == "LVLG");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::lvlo)] == "LVLO");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::nam1)] == "NAM1");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::name)] == "NAME");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::nnam)] == "NNAM");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::pnam)] == "PNAM");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::qnam)] == "QNAM");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::rnam)] == "RNAM");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::snam)] == "SNAM");
+static_assert(field_type_str[static_cast<std::size_t>(field_type_t::trdt)] == "TRDT");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::vmad)] == "VMAD");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::vnam)] == "VNAM");
 static_assert(field_type_str[static_cast<std::size_t>(field_type_t::xnam)] == "XNAM");
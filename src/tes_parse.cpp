@@ -1,5 +1,10 @@
+#include <josk/arena.hpp>
+#include <josk/formid_table.hpp>
+#include <josk/io.hpp>
+#include <josk/stats.hpp>
 #include <josk/tes_format.hpp>
 #include <josk/tes_parse.hpp>
+#include <josk/trace.hpp>
 
 #include <strong_type/affine_point.hpp>
 #include <strong_type/arithmetic.hpp>
@@ -9,6 +14,7 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
@@ -19,33 +25,121 @@
 #include <fstream>
 #include <functional>
 #include <ios>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <span>
+#include <spanstream>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <utility>
 #include <vector>
 
 #include "strong_type/ordered.hpp"
 
-// Keep track of parser actions and show them all in error reports.
+// Keep track of the last parser actions and show them in error reports.
 #define JOSK_USE_PARSER_LOG
 
 namespace josk::tes
 {
 
+#if defined(JOSK_USE_PARSER_LOG)
+/**
+ * Last actions taken by a parser. Entries are stored in a fixed-size ring buffer, so logging never allocates memory
+ * and its cost does not grow with the number of records of the plugin.
+ */
+class parser_log_t final
+{
+public:
+	/** Amount of entries kept. Older entries are overwritten. */
+	static constexpr std::size_t capacity = 32Z;
+	/** Maximum length of an entry. Longer entries are truncated. */
+	static constexpr std::size_t entry_size = 120Z;
+
+	template <typename... Args>
+	void append(const std::format_string<Args...> format, Args&&... args)
+	{
+		auto& entry = _entries[_count % capacity];
+		const auto result = std::format_to_n(entry.text.data(), entry_size, format, std::forward<Args>(args)...);
+		entry.size = std::min(static_cast<std::size_t>(result.size), entry_size);
+		++_count;
+	}
+
+	/**
+	 * Appends all entries kept to a message, from oldest to newest.
+	 * @param message Message receiving the entries.
+	 */
+	void append_to(std::string& message) const
+	{
+		for (auto index = _count - std::min(_count, capacity); index < _count; ++index)
+		{
+			const auto& entry = _entries[index % capacity];
+			message.append(entry.text.data(), entry.size);
+		}
+	}
+
+private:
+	struct entry_t final
+	{
+		std::array<char, entry_size> text;
+		std::size_t size;
+	};
+
+	std::array<entry_t, capacity> _entries{};
+	/** Total amount of entries appended. */
+	std::size_t _count{};
+};
+#endif
+
 /** Data used internally by the parser. */
 struct parser
 {
+	explicit parser(std::pmr::memory_resource* resource)
+		: arena{resource}
+		, topic_pool{resource}
+	{
+	}
+
+	/** Backs the parser itself and all of its transient allocations. Released by its owner after closing the parser. */
+	std::pmr::memory_resource* arena;
+	/** Contents of the plugin file. */
+	io::buffer_t buffer;
+	/** Data of the compressed record being parsed. Its capacity is reused by the next compressed records. */
+	io::buffer_t decompressed_buffer;
+	/** Maps buffer positions to file positions when the buffer does not contain the whole file. */
+	std::vector<plugin_segment_t> segments;
 	/** Avoid using the stream instance directly. Only utility functions should interact with it. */
-	std::ifstream input;
+	std::ispanstream input{std::span<char>{}};
 	/** Identifier for error reporting. */
 	std::string_view name{"Invalid file name"};
+	/** Load order priority of the plugin being parsed. */
+	priority_t priority{invalid_priority};
 	/** A pointer is used to avoid passing non-const references around. Null indicates non-initialized or an error. */
 	parsed_records_t* records{};
+	/** Formids claimed by all plugins being parsed. Shared between parsers running concurrently. */
+	formid_winner_table* winners{};
+	/** Options shared by all parsers. */
+	const parse_options_t* options{};
+	/** Statistics of this plugin. Null if they are not being collected. */
+	stats::plugin_stats_t* stats{};
+	/** WRLD record owning the group being parsed, or invalid_formid outside of worldspaces. */
+	formid_t world_id{invalid_formid};
+	/** CELL record owning the group being parsed, or invalid_formid outside of cell children groups. */
+	formid_t cell_id{invalid_formid};
+	/** DIAL record owning the group being parsed, or invalid_formid outside of topic children groups. */
+	formid_t topic_id{invalid_formid};
+	/**
+	 * Transient allocations of INFO records. Freed memory is pooled and reused by the next records, so the working memory
+	 * of the parser is bounded by its largest topic instead of growing with the whole dialogue tree.
+	 */
+	std::pmr::unsynchronized_pool_resource topic_pool;
+	/** Counts the transient memory requested by each topic. */
+	memory::counting_resource topic_resource{&topic_pool};
 #if defined(JOSK_USE_PARSER_LOG)
-	/** Previous actions taken by the parser. Used in error reports. */
-	std::vector<std::string> log;
+	/** Last actions taken by the parser. Used in error reports. */
+	parser_log_t log;
 #endif
 };
 
@@ -87,7 +181,11 @@ constexpr offset_t record_header_size = section_str_id_offset + offset_sizeof<re
 
 struct group_data_t final
 {
-	josk::tes::record_type_t contained_record_type{josk::tes::record_type_t::none};
+	josk::tes::group_type_t group_type{josk::tes::group_type_t::top};
+	/** Raw group label. Its meaning depends on the group type. */
+	std::uint32_t label{};
+	/** For top groups, the record type in their label. none for any other group type. */
+	josk::tes::record_type_t label_record_type{josk::tes::record_type_t::none};
 	offset_t data_size{invalid_offset};
 	[[nodiscard]] bool operator==(const group_data_t&) const noexcept = default;
 };
@@ -96,10 +194,39 @@ constexpr group_data_t invalid_group_data{};
 
 struct record_header_data final
 {
+	josk::tes::record_type_t record_type;
+	std::uint32_t flags;
 	josk::tes::formid_t record_id;
 	offset_t data_size;
 };
 
+/**
+ * Inflates the data of a record stored with compressed_record_flag.
+ * @param record_data Record data as stored in the plugin file: its uncompressed size followed by a zlib stream.
+ * @param destination Buffer receiving the uncompressed data.
+ * @return Nothing, or an error description starting with lowercase and without a period.
+ */
+std::expected<void, std::string> decompress_record_data(
+		const std::span<const char> record_data, josk::io::buffer_t& destination
+)
+{
+	std::array<char, sizeof(std::uint32_t)> size_field{};
+	if (record_data.size() < size_field.size())
+	{
+		return std::unexpected("compressed record data is smaller than its size field");
+	}
+	std::ranges::copy_n(record_data.begin(), size_field.size(), size_field.begin());
+	const auto uncompressed_size = std::bit_cast<std::uint32_t>(size_field);
+	const auto compressed_data = record_data.subspan(size_field.size());
+
+	destination.resize(uncompressed_size);
+	if (const auto result = josk::io::decompress(compressed_data, destination); !result.has_value())
+	{
+		return std::unexpected(std::format("could not decompress record data: {}", result.error()));
+	}
+	return {};
+}
+
 /**
  * RAII wrapper around the parser state, and definition of functions to interact with it.
  * Its life cycle is restricted to the task function that created it.
@@ -114,8 +241,17 @@ public:
 	using record_type_t = josk::tes::record_type_t;
 
 private:
+	/** Parser states are allocated in their arena, and must be destroyed through it. */
+	struct state_deleter final
+	{
+		void operator()(parser_state* state) const
+		{
+			std::pmr::polymorphic_allocator<parser_state>{state->arena}.delete_object(state);
+		}
+	};
+
 	/** Current parsing state. */
-	std::unique_ptr<parser_state> _state;
+	std::unique_ptr<parser_state, state_deleter> _state;
 
 public:
 	/**
@@ -161,6 +297,43 @@ public:
 	 */
 	void append_record_to_log(std::string_view description, josk::tes::record_type_t record_type);
 
+	/**
+	 * Increments a statistics counter of the plugin, if statistics are being collected.
+	 * @param counter Counter to increment.
+	 */
+	void count(std::uint64_t josk::stats::plugin_stats_t::* counter) noexcept
+	{
+		if constexpr (josk::stats::enabled)
+		{
+			if (_state->stats != nullptr)
+			{
+				josk::stats::count(_state->stats->*counter);
+			}
+		}
+	}
+
+	/**
+	 * Updates the largest amount of transient memory requested by a topic, if statistics are being collected.
+	 * @param topic_bytes Transient memory requested by the last topic.
+	 */
+	void update_peak_topic_bytes([[maybe_unused]] const std::uint64_t topic_bytes) noexcept
+	{
+		if constexpr (josk::stats::enabled)
+		{
+			if (_state->stats != nullptr)
+			{
+				_state->stats->peak_topic_bytes = std::max(_state->stats->peak_topic_bytes, topic_bytes);
+			}
+		}
+	}
+
+	/**
+	 * Adds a group entry for the current state if JOSK_USE_PARSER_LOG is defined.
+	 * @param description Short description of the state. Must start with lowercase and not end with a period.
+	 * @param group_data Group being processed.
+	 */
+	void append_group_to_log(std::string_view description, const group_data_t& group_data);
+
 	/**
 	 * Releases the internal parser state from RAII management. Intended to pass the state to the next task.
 	 * @return Pointer to the internal parser state.
@@ -185,26 +358,76 @@ public:
 	[[nodiscard]] float parse_float();
 
 	/**
-	 * Open the next record group. The parser must be at the beginning of the group.
+	 * Open the next record group. The parser must be at the beginning of the group header.
 	 * @return invalid_group_data if no more groups remain, valid group data otherwise. An error string if applicable.
 	 */
 	[[nodiscard]] std::expected<group_data_t, std::string> next_group();
 
 	/**
-	 * Parse individual records in a group.
+	 * Parse the records and subgroups of a group. Subgroups which cannot contain any of the requested record types are
+	 * skipped using their size. The parser must be at the start of the group data.
 	 * @param group_data Group data.
 	 * @return Nothing, or an error.
 	 */
 	[[nodiscard]] std::expected<void, std::string> parse_group(group_data_t group_data);
 
-	std::expected<record_header_data, std::string> parse_record_header(record_type_t record_type);
+	/**
+	 * Parse a single record, if its type has been requested. Skip it otherwise.
+	 * The parser must be at the beginning of the record header.
+	 * @return Nothing, or an error.
+	 */
+	[[nodiscard]] std::expected<void, std::string> parse_record();
+
+	std::expected<record_header_data, std::string> parse_record_header();
 
 	std::expected<bool, std::string> parse_perk(josk::tes::formid_t record_id, pos_t record_data_end);
 	std::expected<bool, std::string> parse_avif(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_cobj(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_dial(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_info(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_achr(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_refr(josk::tes::formid_t record_id, pos_t record_data_end);
+	/**
+	 * Placed references of all types share the fields used by josk. Their cell and worldspace are taken from the groups
+	 * containing them.
+	 * @param record_type ACHR or REFR.
+	 * @param record_id Formid of the record.
+	 * @param record_data_end End position of the record data.
+	 * @return True if the record was accepted, or an error.
+	 */
+	std::expected<bool, std::string> parse_placed_reference(
+			record_type_t record_type, josk::tes::formid_t record_id, pos_t record_data_end
+	);
+	std::expected<bool, std::string> parse_lvli(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_lvln(josk::tes::formid_t record_id, pos_t record_data_end);
+	std::expected<bool, std::string> parse_lvsp(josk::tes::formid_t record_id, pos_t record_data_end);
+	/**
+	 * Leveled lists of all types share the same fields, which may appear in any order.
+	 * @param record_type LVLI, LVLN or LVSP.
+	 * @param record_id Formid of the record.
+	 * @param record_data_end End position of the record data.
+	 * @return True if the record was accepted, or an error.
+	 */
+	std::expected<bool, std::string> parse_leveled_list(
+			record_type_t record_type, josk::tes::formid_t record_id, pos_t record_data_end
+	);
 	/** Besides returning errors, parse functions may return false if the record has to be ignored. */
 	using record_parse_func = std::expected<bool, std::string> (parser_impl::*)(josk::tes::formid_t, pos_t);
 	[[nodiscard]] static record_parse_func get_record_parse_func(record_type_t record_type) noexcept;
 
+	/**
+	 * Parses the data of a record, decompressing it first if needed. The parser must be at the start of the record data,
+	 * and it is left at its end.
+	 * @param parse_func Parse function of the record type.
+	 * @param record_id Formid of the record.
+	 * @param record_flags Flags of the record header.
+	 * @param record_data_end End position of the record data, as stored in the plugin.
+	 * @return True if the record was accepted, or an error.
+	 */
+	[[nodiscard]] std::expected<bool, std::string> parse_record_data(
+			record_parse_func parse_func, josk::tes::formid_t record_id, std::uint32_t record_flags, pos_t record_data_end
+	);
+
 	[[nodiscard]] section_str_id parse_section_id();
 	[[nodiscard]] record_type_t parse_record_type();
 	[[nodiscard]] offset_t parse_record_size();
@@ -219,7 +442,21 @@ public:
 		return value;
 	}
 
+	/** Reads a string field into an existing string, keeping its allocator. */
+	void parse_string_field_value(std::pmr::string& value, offset_t size)
+	{
+		value.resize(static_cast<std::pmr::string::size_type>(size.value_of()));
+		_state->input.read(value.data(), size.value_of());
+	}
+
 	[[nodiscard]] pos_t current_position();
+
+	/**
+	 * Converts a position of the parser into a position of the plugin file.
+	 * @param position Parser position.
+	 * @return File position.
+	 */
+	[[nodiscard]] std::uint64_t file_offset(pos_t position) const noexcept;
 	void seek_position(pos_t position);
 	void seek_offset(offset_t offset);
 
@@ -239,6 +476,14 @@ public:
 	 */
 	[[nodiscard]] bool validate_field_type(field_type_t field_type);
 
+	/**
+	 * Parses all consecutive CTDA fields found next in the stream, along with their CIS1 and CIS2 parameters.
+	 * The stream position will be moved to the end of the last condition.
+	 * @param program Program receiving the conditions.
+	 * @return False if any condition is malformed.
+	 */
+	[[nodiscard]] bool parse_conditions(josk::tes::condition_program_t& program);
+
 	/**
 	 * Skip the next field, depending on its type.
 	 * @param field_type Field type to ignore.
@@ -297,10 +542,7 @@ std::string parser_impl::error_message(const std::string_view description)
 	constexpr std::string_view format{"Parse error in {}: {}. State: {}, position: 0x{:x}"};
 	auto message = std::format(format, _state->name, description, stream_status, position);
 #if defined(JOSK_USE_PARSER_LOG)
-	for (const auto& log_entry : _state->log)
-	{
-		message += log_entry;
-	}
+	_state->log.append_to(message);
 #endif
 
 	return message;
@@ -309,19 +551,33 @@ std::string parser_impl::error_message(const std::string_view description)
 void parser_impl::append_to_log([[maybe_unused]] const std::string_view description)
 {
 #if defined(JOSK_USE_PARSER_LOG)
-	constexpr std::string_view format{"\n{} at 0x{:x}"};
-	_state->log.emplace_back(std::format(format, description, current_position()));
+	_state->log.append("\n{} at 0x{:x}", description, current_position());
 #endif
 }
 
 void parser_impl::append_record_to_log(const std::string_view description, const josk::tes::record_type_t record_type)
 {
 #if defined(JOSK_USE_PARSER_LOG)
-	constexpr std::string_view format{"\n{} {} at 0x{:x}"};
-	_state->log.emplace_back(
-			std::format(
-					format, josk::tes::record_type_str[static_cast<std::size_t>(record_type)], description, current_position()
-			)
+	_state->log.append(
+			"\n{} {} at 0x{:x}", josk::tes::record_type_str[static_cast<std::size_t>(record_type)], description,
+			current_position()
+	);
+#endif
+}
+
+void parser_impl::append_group_to_log(
+		[[maybe_unused]] const std::string_view description, [[maybe_unused]] const group_data_t& group_data
+)
+{
+#if defined(JOSK_USE_PARSER_LOG)
+	if (group_data.group_type == josk::tes::group_type_t::top)
+	{
+		append_record_to_log(description, group_data.label_record_type);
+		return;
+	}
+	_state->log.append(
+			"\nGRUP type {} label 0x{:x} {} at 0x{:x}", static_cast<std::int32_t>(group_data.group_type), group_data.label,
+			description, current_position()
 	);
 #endif
 }
@@ -352,85 +608,106 @@ std::expected<group_data_t, std::string> parser_impl::next_group()
 
 	// In GRUP headers, the data size field includes GRUP header size.
 	const auto total_grup_size = parse_record_size();
-	constexpr offset_t grup_header_remaining_size =
-			offset_sizeof<std::uint32_t>() + offset_sizeof<josk::tes::formid_t>() + offset_sizeof<std::uint16_t>(4Z);
-
-	constexpr offset_t grup_header_total_size =
-			section_str_id_offset + offset_sizeof<record_size_t>() + grup_header_remaining_size;
+	const auto label = parse_section_id();
+	const auto group_type = parse_integral<std::int32_t>();
+	constexpr offset_t grup_header_remaining_size = offset_sizeof<std::uint16_t>(2Z) + offset_sizeof<std::uint32_t>();
+
+	constexpr offset_t grup_header_total_size = section_str_id_offset + offset_sizeof<record_size_t>() +
+																							section_str_id_offset + offset_sizeof<std::int32_t>() +
+																							grup_header_remaining_size;
+	static_assert(grup_header_total_size == record_header_size);
 	if (total_grup_size < grup_header_total_size)
 	{
 		return std::unexpected(error_message("Invalid GRUP size"));
 	}
-	// Seek to the end of the header of the current GRUP.
-	seek_offset(grup_header_remaining_size);
-	if (total_grup_size == grup_header_total_size)
+	if (group_type < 0 || static_cast<std::int32_t>(josk::tes::max_group_type) < group_type)
 	{
-		// This is an empty group with no records.
-		// Zero data size and an invalid record type will skip data parsing.
-		return group_data_t{.contained_record_type = record_type_t::grup, .data_size = offset_t{0U}};
+		return std::unexpected(error_message(std::format("unknown GRUP type {}", group_type)));
 	}
+	// Seek to the end of the header of the current GRUP.
+	seek_offset(grup_header_remaining_size);
 
-	// Peek the header of the first contained record to find its record type id.
-	const auto contained_record_type = parse_record_type();
-	// Return the stream to the start of the header of the first record.
-	seek_offset(-section_str_id_offset);
-
-	return group_data_t{
-			.contained_record_type = contained_record_type, .data_size = total_grup_size - grup_header_total_size
+	group_data_t group_data{
+			.group_type = static_cast<josk::tes::group_type_t>(group_type),
+			.label = std::bit_cast<std::uint32_t>(label),
+			.data_size = total_grup_size - grup_header_total_size,
 	};
+	if (group_data.group_type == josk::tes::group_type_t::top)
+	{
+		group_data.label_record_type = josk::tes::to_record_type(std::string_view(label.data(), label.size()));
+	}
+	return group_data;
 }
 
 std::expected<void, std::string> parser_impl::parse_group(const group_data_t group_data)
 {
-	const auto& [contained_record_type, group_data_size] = group_data;
 	if (get_status() != parser_status_t::valid)
 	{
-		const auto formatted_error = std::format(
-				"invalid file stream state while parsing {} record group", josk::tes::to_record_string(contained_record_type)
-		);
-		return std::unexpected(error_message(formatted_error));
+		return std::unexpected(error_message("invalid file stream state while parsing record group"));
 	}
 
-	const pos_t group_data_end = current_position() + group_data_size;
+	const pos_t group_data_end = current_position() + group_data.data_size;
 
-	const auto parse_func = get_record_parse_func(contained_record_type);
-	if (parse_func == nullptr)
+	if (const auto group_types = josk::tes::group_record_types(group_data.group_type, group_data.label_record_type);
+			(group_types & _state->options->record_types).none())
 	{
-		// Group that does not require parsing.
+		// Group that does not require parsing. Its whole subtree is skipped in a single seek.
 		seek_position(group_data_end);
-		append_record_to_log("group ignored", contained_record_type);
+		count(&josk::stats::plugin_stats_t::groups_skipped);
+		append_group_to_log("group ignored", group_data);
 		return {};
 	}
-	append_record_to_log("group data start", contained_record_type);
+	count(&josk::stats::plugin_stats_t::groups_visited);
+	append_group_to_log("group data start", group_data);
+
+	// Placed references get their worldspace and cell from the groups containing them, and responses their topic.
+	const auto parent_world_id = _state->world_id;
+	const auto parent_cell_id = _state->cell_id;
+	const auto parent_topic_id = _state->topic_id;
+	const auto topic_start_bytes = _state->topic_resource.allocated_bytes();
+	switch (group_data.group_type)
+	{
+		case josk::tes::group_type_t::world_children:
+			_state->world_id = group_data.label;
+			break;
+		case josk::tes::group_type_t::interior_cell_block:
+			_state->world_id = josk::tes::invalid_formid;
+			break;
+		case josk::tes::group_type_t::cell_children:
+		case josk::tes::group_type_t::cell_persistent_children:
+		case josk::tes::group_type_t::cell_temporary_children:
+			_state->cell_id = group_data.label;
+			break;
+		case josk::tes::group_type_t::topic_children:
+			_state->topic_id = group_data.label;
+			break;
+		default:
+			break;
+	}
 
 	while (current_position() < group_data_end)
 	{
-		append_record_to_log("record header start", contained_record_type);
-		auto parse_header_result = parse_record_header(contained_record_type);
-		if (!parse_header_result.has_value())
+		// Peek the type of the next section to check if it is a record or a subgroup.
+		const auto section_type = parse_record_type();
+		if (get_status() != parser_status_t::valid)
 		{
-			return std::unexpected(parse_header_result.error());
+			return std::unexpected(error_message("invalid file stream state while parsing record group"));
 		}
+		seek_offset(-section_str_id_offset);
 
-		const auto& [record_type, record_data_size] = parse_header_result.value();
-
-		const auto record_data_end = current_position() + record_data_size;
-
-		if (auto& parsed_record_ids = _state->records->parsed_record_ids; !parsed_record_ids.contains(record_type))
+		if (section_type == record_type_t::grup)
 		{
-			append_record_to_log("record data start", contained_record_type);
-			const auto parse_record_data_result = std::invoke(parse_func, *this, record_type, record_data_end);
-			if (!parse_record_data_result.has_value())
-			{
-				return std::unexpected(parse_record_data_result.error());
-			}
-			if (parse_record_data_result.value())
+			auto subgroup_result = next_group().and_then([this](const group_data_t subgroup_data)
+																									 { return parse_group(subgroup_data); });
+			if (!subgroup_result.has_value())
 			{
-				parsed_record_ids.emplace(record_type);
+				return std::unexpected(subgroup_result.error());
 			}
 		}
-		seek_position(record_data_end);
-		append_record_to_log("record data end", contained_record_type);
+		else if (auto parse_record_result = parse_record(); !parse_record_result.has_value())
+		{
+			return std::unexpected(parse_record_result.error());
+		}
 	}
 
 	if (current_position() != group_data_end)
@@ -438,22 +715,141 @@ std::expected<void, std::string> parser_impl::parse_group(const group_data_t gro
 		const auto formatted_error = std::format("group parsing did not reach expected end position {}", group_data_end);
 		return std::unexpected(error_message(formatted_error));
 	}
+	_state->world_id = parent_world_id;
+	_state->cell_id = parent_cell_id;
+	_state->topic_id = parent_topic_id;
+	if (group_data.group_type == josk::tes::group_type_t::topic_children)
+	{
+		count(&josk::stats::plugin_stats_t::topics);
+		update_peak_topic_bytes(_state->topic_resource.allocated_bytes() - topic_start_bytes);
+	}
 
-	append_to_log("Group data end");
+	append_group_to_log("group data end", group_data);
 	return {};
 }
 
-std::expected<record_header_data, std::string> parser_impl::parse_record_header(const record_type_t record_type)
+std::expected<void, std::string> parser_impl::parse_record()
+{
+	append_to_log("Record header start");
+	auto parse_header_result = parse_record_header();
+	if (!parse_header_result.has_value())
+	{
+		return std::unexpected(parse_header_result.error());
+	}
+
+	const auto& [record_type, record_flags, record_id, record_data_size] = parse_header_result.value();
+
+	const auto record_data_start = current_position();
+	const auto record_data_end = record_data_start + record_data_size;
+
+	const auto parse_func = get_record_parse_func(record_type);
+	if (parse_func == nullptr || !_state->options->record_types.test(static_cast<std::size_t>(record_type)))
+	{
+		// Records of types that have not been requested, found in groups which also contain requested types.
+		seek_position(record_data_end);
+		append_record_to_log("record ignored", record_type);
+		return {};
+	}
+
+	count(&josk::stats::plugin_stats_t::records_seen);
+	auto& winners = *_state->winners;
+	if (_state->options->mode == josk::tes::parse_mode_t::index)
+	{
+		// Every version is indexed. Decoding may reject a version, and then the next one by priority must be used.
+		const auto data_begin = static_cast<std::size_t>(record_data_start.value_of());
+		const auto data_size = static_cast<std::size_t>(record_data_size.value_of());
+		if (_state->buffer.size() < data_begin + data_size)
+		{
+			return std::unexpected(error_message("record data exceeds the end of the file"));
+		}
+		// Each version is hashed once while it is in memory, so that conflicts can be found without reading it again.
+		const auto fingerprint =
+				josk::tes::record_fingerprint(record_flags, std::span{_state->buffer}.subspan(data_begin, data_size));
+		_state->records->record_handles.emplace_back(josk::tes::record_handle_t{
+				.record_id = record_id,
+				.record_type = record_type,
+				.priority = _state->priority,
+				.world_id = _state->world_id,
+				.cell_id = _state->cell_id,
+				.topic_id = _state->topic_id,
+				.offset = file_offset(record_data_start),
+				.size = static_cast<std::uint32_t>(data_size),
+				.flags = record_flags,
+				.fingerprint = fingerprint,
+		});
+	}
+	// Records already claimed by a plugin with higher priority are skipped without decoding them.
+	else if (auto& parsed_record_ids = _state->records->parsed_record_ids;
+					 !parsed_record_ids.contains(record_id) &&
+					 !(_state->options->skip_claimed && winners.claimed_by_higher(record_id, _state->priority)))
+	{
+		append_record_to_log("record data start", record_type);
+		const auto parse_record_data_result = parse_record_data(parse_func, record_id, record_flags, record_data_end);
+		if (!parse_record_data_result.has_value())
+		{
+			return std::unexpected(parse_record_data_result.error());
+		}
+		if (parse_record_data_result.value())
+		{
+			parsed_record_ids.emplace(record_id);
+			winners.claim(record_id, _state->priority);
+		}
+	}
+	else if (!parsed_record_ids.contains(record_id))
+	{
+		count(&josk::stats::plugin_stats_t::records_overridden);
+	}
+	seek_position(record_data_end);
+	append_record_to_log("record data end", record_type);
+	return {};
+}
+
+std::expected<bool, std::string> parser_impl::parse_record_data(
+		const record_parse_func parse_func, const formid_t record_id, const std::uint32_t record_flags,
+		const pos_t record_data_end
+)
 {
-	// Record type is known.
-	if (!validate_record_type(record_type))
+	if ((record_flags & josk::tes::compressed_record_flag) == 0U)
 	{
-		return std::unexpected(error_message("unexpected record type while parsing group"));
+		return std::invoke(parse_func, *this, record_id, record_data_end);
 	}
+
+	const auto data_begin = static_cast<std::size_t>(current_position().value_of());
+	const auto data_end = static_cast<std::size_t>(record_data_end.value_of());
+	if (get_status() != parser_status_t::valid || _state->buffer.size() < data_end)
+	{
+		return std::unexpected(error_message("compressed record data exceeds the end of the file"));
+	}
+	auto& decompressed_buffer = _state->decompressed_buffer;
+	if (const auto decompress_result = decompress_record_data(
+					std::span{_state->buffer}.subspan(data_begin, data_end - data_begin), decompressed_buffer
+			);
+			!decompress_result.has_value())
+	{
+		return std::unexpected(error_message(decompress_result.error()));
+	}
+	count(&josk::stats::plugin_stats_t::records_decompressed);
+
+	// The uncompressed data is parsed from its own stream. Positions are relative to its start until the parser goes
+	// back to the plugin data.
+	_state->input.span(decompressed_buffer);
+	const auto decompressed_end = pos_t{static_cast<std::int64_t>(decompressed_buffer.size())};
+	auto parse_result = std::invoke(parse_func, *this, record_id, decompressed_end);
+	_state->input.span(_state->buffer);
+	seek_position(record_data_end);
+	return parse_result;
+}
+
+std::expected<record_header_data, std::string> parser_impl::parse_record_header()
+{
 	record_header_data header_data{};
+	header_data.record_type = parse_record_type();
+	if (header_data.record_type == record_type_t::grup)
+	{
+		return std::unexpected(error_message("unexpected GRUP header while parsing record"));
+	}
 	header_data.data_size = parse_record_size();
-	// Flags are currently not required by josk.
-	seek_offset(offset_sizeof<std::uint32_t>());
+	header_data.flags = parse_integral<std::uint32_t>();
 	header_data.record_id = parse_formid();
 	constexpr offset_t remaining_header_size_after_formid = record_header_size - section_str_id_offset -
 																													offset_sizeof<record_size_t>() -
@@ -509,7 +905,7 @@ std::expected<bool, std::string> parser_impl::parse_avif(
 
 	ignore_field_if_present(field_type_t::avsk);
 
-	std::vector<josk::tes::avif_perk> perks;
+	std::pmr::vector<josk::tes::avif_perk> perks{_state->arena};
 	while (current_position() < record_data_end)
 	{
 		// Perks are parsed first. If any errors are found, the avif record will not be created.
@@ -566,7 +962,7 @@ std::expected<bool, std::string> parser_impl::parse_avif(
 	avif_record.name = parse_string_field_value(name_size);
 	seek_position(description_position);
 	avif_record.description = parse_string_field_value(description_size);
-	avif_record.perks = std::move(perks);
+	avif_record.perks.assign(perks.cbegin(), perks.cend());
 
 	return true;
 }
@@ -601,9 +997,10 @@ std::expected<bool, std::string> parser_impl::parse_perk(
 
 	ignore_field_if_present(field_type_t::icon);
 
-	// ToDo parse conditions
-	while (ignore_field_if_present(field_type_t::ctda))
+	josk::tes::condition_program_t conditions;
+	if (!parse_conditions(conditions))
 	{
+		return false;
 	}
 
 	if (!validate_field_type(field_type_t::data))
@@ -627,7 +1024,7 @@ std::expected<bool, std::string> parser_impl::parse_perk(
 	formid_t next_perk_id{josk::tes::invalid_formid};
 	if (validate_field_type(field_type_t::nnam))
 	{
-		seek_offset(parse_field_size());
+		seek_offset(offset_sizeof<field_size_t>());
 		next_perk_id = parse_formid();
 	}
 
@@ -638,18 +1035,392 @@ std::expected<bool, std::string> parser_impl::parse_perk(
 	seek_position(description_position);
 	perk_record.description = parse_string_field_value(description_size);
 	perk_record.next_perk_id = next_perk_id;
+	// Skill level and prerequisite perks are expressed as conditions.
+	for (const auto& condition : conditions.conditions)
+	{
+		if (condition.run_on != josk::tes::condition_run_on_t::subject ||
+				(condition.flags & josk::tes::condition_use_global_flag) != 0U)
+		{
+			continue;
+		}
+		if (condition.function == josk::tes::condition_function_t::has_perk &&
+				condition.op == josk::tes::compare_op_t::equal && condition.value == 1.0F)
+		{
+			perk_record.prereq_perk_ids.emplace_back(condition.param1);
+		}
+		else if (condition.function == josk::tes::condition_function_t::get_base_actor_value &&
+						 condition.op == josk::tes::compare_op_t::greater_equal && 0.0F <= condition.value &&
+						 condition.value <= static_cast<float>(std::numeric_limits<std::uint8_t>::max()))
+		{
+			perk_record.skill_req = static_cast<std::uint8_t>(condition.value);
+		}
+	}
+	perk_record.conditions = std::move(conditions);
+
+	return true;
+}
+
+std::expected<bool, std::string> parser_impl::parse_cobj(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	josk::tes::cobj_record cobj{};
+	cobj.record_id = record_id;
+	std::pmr::vector<josk::tes::recipe_component> components{_state->arena};
+	while (current_position() < record_data_end)
+	{
+		const auto field_start = current_position();
+		const auto field_id = parse_section_id();
+		const auto field_size = parse_field_size();
+		if (get_status() != parser_status_t::valid)
+		{
+			return std::unexpected(error_message("invalid file stream state while parsing constructible object"));
+		}
+		const auto field_end = current_position() + field_size;
+
+		switch (josk::tes::to_field_type(std::string_view(field_id.data(), field_id.size())))
+		{
+			case field_type_t::cnto:
+			{
+				if (field_size != offset_sizeof<std::uint32_t>(2Z))
+				{
+					return false;
+				}
+				auto& component = components.emplace_back();
+				component.record_id = parse_formid();
+				component.count = parse_integral<std::int32_t>();
+				break;
+			}
+			case field_type_t::ctda:
+				// Conditions are parsed together with their string parameters, and leave the stream at the next field.
+				seek_position(field_start);
+				if (!parse_conditions(cobj.conditions))
+				{
+					return false;
+				}
+				continue;
+			case field_type_t::cnam:
+				cobj.created_object_id = parse_formid();
+				break;
+			case field_type_t::bnam:
+				cobj.workbench_keyword_id = parse_formid();
+				break;
+			case field_type_t::nam1:
+				cobj.created_count = parse_integral<std::uint16_t>();
+				break;
+			default:
+				// Other fields such as EDID, COCT and COED are not needed.
+				break;
+		}
+		seek_position(field_end);
+	}
+
+	cobj.components.assign(components.cbegin(), components.cend());
+	_state->records->cobj_records.emplace_back(std::move(cobj));
+	return true;
+}
+
+std::expected<bool, std::string> parser_impl::parse_dial(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	josk::tes::dial_record dial{};
+	dial.record_id = record_id;
+	while (current_position() < record_data_end)
+	{
+		const auto field_id = parse_section_id();
+		const auto field_size = parse_field_size();
+		if (get_status() != parser_status_t::valid)
+		{
+			return std::unexpected(error_message("invalid file stream state while parsing dialogue topic"));
+		}
+		const auto field_end = current_position() + field_size;
+
+		switch (josk::tes::to_field_type(std::string_view(field_id.data(), field_id.size())))
+		{
+			case field_type_t::full:
+				dial.name = parse_string_field_value(field_size);
+				break;
+			case field_type_t::qnam:
+				dial.quest_id = parse_formid();
+				break;
+			case field_type_t::data:
+				if (field_size != offset_sizeof<std::uint32_t>())
+				{
+					return false;
+				}
+				seek_offset(offset_sizeof<std::uint8_t>());
+				dial.category = parse_integral<std::uint8_t>();
+				dial.subtype = parse_integral<std::uint16_t>();
+				break;
+			default:
+				// Other fields such as PNAM, BNAM, SNAM and TIFC are not needed.
+				break;
+		}
+		seek_position(field_end);
+	}
+
+	_state->records->dial_records.emplace_back(std::move(dial));
+	return true;
+}
+
+std::expected<bool, std::string> parser_impl::parse_info(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	if (_state->topic_id == josk::tes::invalid_formid)
+	{
+		// Responses must always be placed inside of a topic children group.
+		return false;
+	}
 
+	josk::tes::info_record info{};
+	info.record_id = record_id;
+	info.topic_id = _state->topic_id;
+	// Responses are kept in the topic pool until the record is accepted, and only then copied into the parsed record.
+	struct pending_response_t final
+	{
+		std::uint8_t response_number{};
+		std::pmr::string text;
+	};
+	std::pmr::vector<pending_response_t> responses{&_state->topic_resource};
+	const auto add_response = [this, &responses]() -> pending_response_t&
+	{ return responses.emplace_back(pending_response_t{.text = std::pmr::string{&_state->topic_resource}}); };
+	while (current_position() < record_data_end)
+	{
+		const auto field_start = current_position();
+		const auto field_id = parse_section_id();
+		const auto field_size = parse_field_size();
+		if (get_status() != parser_status_t::valid)
+		{
+			return std::unexpected(error_message("invalid file stream state while parsing dialogue response"));
+		}
+		const auto field_end = current_position() + field_size;
+
+		switch (josk::tes::to_field_type(std::string_view(field_id.data(), field_id.size())))
+		{
+			case field_type_t::pnam:
+				info.previous_info_id = parse_formid();
+				break;
+			case field_type_t::trdt:
+			{
+				// Emotion type and value, followed by the unused quest and the response number.
+				constexpr offset_t response_number_offset = offset_sizeof<std::uint32_t>(3Z);
+				if (field_size < response_number_offset + offset_sizeof<std::uint8_t>())
+				{
+					return false;
+				}
+				seek_offset(response_number_offset);
+				add_response().response_number = parse_integral<std::uint8_t>();
+				break;
+			}
+			case field_type_t::nam1:
+				if (responses.empty())
+				{
+					add_response();
+				}
+				parse_string_field_value(responses.back().text, field_size);
+				break;
+			case field_type_t::ctda:
+				// Conditions are parsed together with their string parameters, and leave the stream at the next field.
+				seek_position(field_start);
+				if (!parse_conditions(info.conditions))
+				{
+					return false;
+				}
+				continue;
+			case field_type_t::rnam:
+				info.prompt = parse_string_field_value(field_size);
+				break;
+			default:
+				// Other fields such as scripts, speakers, sounds and animations are not needed.
+				break;
+		}
+		seek_position(field_end);
+	}
+
+	info.responses.reserve(responses.size());
+	for (const auto& response : responses)
+	{
+		info.responses.emplace_back(
+				josk::tes::info_response{.response_number = response.response_number, .text = std::string{response.text}}
+		);
+	}
+	_state->records->info_records.emplace_back(std::move(info));
 	return true;
 }
 
+std::expected<bool, std::string> parser_impl::parse_placed_reference(
+		const record_type_t record_type, const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	if (_state->cell_id == josk::tes::invalid_formid)
+	{
+		// References must always be placed inside of a cell children group.
+		return false;
+	}
+
+	josk::tes::placed_reference reference{};
+	reference.record_id = record_id;
+	reference.world_id = _state->world_id;
+	reference.cell_id = _state->cell_id;
+	reference.record_type = record_type;
+	bool has_position{};
+	while (current_position() < record_data_end)
+	{
+		const auto field_id = parse_section_id();
+		const auto field_size = parse_field_size();
+		if (get_status() != parser_status_t::valid)
+		{
+			return std::unexpected(error_message("invalid file stream state while parsing placed reference"));
+		}
+		const auto field_end = current_position() + field_size;
+
+		switch (josk::tes::to_field_type(std::string_view(field_id.data(), field_id.size())))
+		{
+			case field_type_t::name:
+				reference.base_id = parse_formid();
+				break;
+			case field_type_t::data:
+				// Position followed by rotation.
+				if (field_size != offset_sizeof<float>(6Z))
+				{
+					return false;
+				}
+				for (auto& coordinate : reference.position)
+				{
+					coordinate = parse_float();
+				}
+				has_position = true;
+				break;
+			default:
+				// References have many optional fields, such as ownership, lighting or enable parents.
+				break;
+		}
+		seek_position(field_end);
+	}
+
+	if (reference.base_id == josk::tes::invalid_formid || !has_position)
+	{
+		return false;
+	}
+	_state->records->placed_references.emplace_back(reference);
+	return true;
+}
+
+std::expected<bool, std::string> parser_impl::parse_achr(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	return parse_placed_reference(record_type_t::achr, record_id, record_data_end);
+}
+
+std::expected<bool, std::string> parser_impl::parse_refr(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	return parse_placed_reference(record_type_t::refr, record_id, record_data_end);
+}
+
+std::expected<bool, std::string> parser_impl::parse_leveled_list(
+		const record_type_t record_type, const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	josk::tes::leveled_list_record leveled_list{};
+	leveled_list.record_id = record_id;
+	leveled_list.record_type = record_type;
+	std::pmr::vector<josk::tes::leveled_entry> entries{_state->arena};
+	while (current_position() < record_data_end)
+	{
+		const auto field_id = parse_section_id();
+		const auto field_size = parse_field_size();
+		if (get_status() != parser_status_t::valid)
+		{
+			return std::unexpected(error_message("invalid file stream state while parsing leveled list"));
+		}
+		const auto field_end = current_position() + field_size;
+
+		switch (josk::tes::to_field_type(std::string_view(field_id.data(), field_id.size())))
+		{
+			case field_type_t::lvld:
+				leveled_list.chance_none = parse_integral<std::uint8_t>();
+				break;
+			case field_type_t::lvlf:
+				leveled_list.flags = parse_integral<std::uint8_t>();
+				break;
+			case field_type_t::lvlg:
+				leveled_list.chance_none_global = parse_formid();
+				break;
+			case field_type_t::lvlo:
+			{
+				if (field_size != offset_sizeof<std::uint32_t>(3Z))
+				{
+					return false;
+				}
+				auto& entry = entries.emplace_back();
+				entry.level = parse_integral<std::uint16_t>();
+				seek_offset(offset_sizeof<std::uint16_t>());
+				entry.record_id = parse_formid();
+				entry.count = parse_integral<std::uint16_t>();
+				break;
+			}
+			default:
+				// Other fields such as OBND, LLCT and COED are not needed.
+				break;
+		}
+		seek_position(field_end);
+	}
+
+	leveled_list.entries.assign(entries.cbegin(), entries.cend());
+	_state->records->leveled_list_records.emplace_back(std::move(leveled_list));
+	return true;
+}
+
+std::expected<bool, std::string> parser_impl::parse_lvli(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	return parse_leveled_list(record_type_t::lvli, record_id, record_data_end);
+}
+
+std::expected<bool, std::string> parser_impl::parse_lvln(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	return parse_leveled_list(record_type_t::lvln, record_id, record_data_end);
+}
+
+std::expected<bool, std::string> parser_impl::parse_lvsp(
+		const josk::tes::formid_t record_id, const pos_t record_data_end
+)
+{
+	return parse_leveled_list(record_type_t::lvsp, record_id, record_data_end);
+}
+
 parser_impl::record_parse_func parser_impl::get_record_parse_func(const record_type_t record_type) noexcept
 {
 	switch (record_type)
 	{
+		case record_type_t::achr:
+			return &parser_impl::parse_achr;
 		case record_type_t::avif:
 			return &parser_impl::parse_avif;
+		case record_type_t::cobj:
+			return &parser_impl::parse_cobj;
+		case record_type_t::dial:
+			return &parser_impl::parse_dial;
+		case record_type_t::info:
+			return &parser_impl::parse_info;
+		case record_type_t::lvli:
+			return &parser_impl::parse_lvli;
+		case record_type_t::lvln:
+			return &parser_impl::parse_lvln;
+		case record_type_t::lvsp:
+			return &parser_impl::parse_lvsp;
 		case record_type_t::perk:
 			return &parser_impl::parse_perk;
+		case record_type_t::refr:
+			return &parser_impl::parse_refr;
 		default:
 			break;
 	}
@@ -697,14 +1468,27 @@ pos_t parser_impl::current_position()
 	return pos_t{_state->input.tellg()};
 }
 
+std::uint64_t parser_impl::file_offset(const pos_t position) const noexcept
+{
+	const auto buffer_offset = static_cast<std::uint64_t>(position.value_of());
+	const auto& segments = _state->segments;
+	const auto itr = std::ranges::upper_bound(segments, buffer_offset, {}, &josk::tes::plugin_segment_t::buffer_offset);
+	if (itr == segments.cbegin())
+	{
+		return buffer_offset;
+	}
+	const auto& segment = *std::prev(itr);
+	return segment.file_offset + (buffer_offset - segment.buffer_offset);
+}
+
 void parser_impl::seek_position(const pos_t position)
 {
-	_state->input.seekg(static_cast<std::ifstream::pos_type>(position.value_of()));
+	_state->input.seekg(static_cast<std::ispanstream::pos_type>(position.value_of()));
 }
 
 void parser_impl::seek_offset(const offset_t offset)
 {
-	_state->input.seekg(static_cast<std::ifstream::off_type>(offset.value_of()), std::ios_base::cur);
+	_state->input.seekg(static_cast<std::ispanstream::off_type>(offset.value_of()), std::ios_base::cur);
 }
 
 bool parser_impl::validate_record_type(const record_type_t record_type)
@@ -733,6 +1517,64 @@ bool parser_impl::ignore_field_if_present(const field_type_t field_type)
 	return false;
 }
 
+bool parser_impl::parse_conditions(josk::tes::condition_program_t& program)
+{
+	using josk::tes::compare_op_t;
+	using josk::tes::condition_run_on_t;
+
+	// String parameters are stored right after the condition using them.
+	const auto parse_string_parameter = [this, &program](const field_type_t field_type)
+	{
+		if (!validate_field_type(field_type))
+		{
+			seek_offset(-section_str_id_offset);
+			return josk::tes::no_condition_string;
+		}
+		const auto string_index = static_cast<std::uint16_t>(program.strings.size());
+		program.strings.emplace_back(parse_string_field_value(parse_field_size()));
+		return string_index;
+	};
+
+	constexpr offset_t ctda_size = offset_sizeof<std::uint32_t>(8Z);
+	while (validate_field_type(field_type_t::ctda))
+	{
+		if (parse_field_size() != ctda_size)
+		{
+			return false;
+		}
+
+		josk::tes::condition_t condition{};
+		const auto op_and_flags = parse_integral<std::uint8_t>();
+		const auto op = static_cast<std::uint8_t>(op_and_flags >> 5U);
+		if (static_cast<std::uint8_t>(compare_op_t::less_equal) < op)
+		{
+			return false;
+		}
+		condition.op = static_cast<compare_op_t>(op);
+		condition.flags = static_cast<std::uint8_t>(op_and_flags & 0x1FU);
+		seek_offset(offset_sizeof<std::uint8_t>(3Z));
+		condition.value = parse_float();
+		condition.function = static_cast<josk::tes::condition_function_t>(parse_integral<std::uint16_t>());
+		seek_offset(offset_sizeof<std::uint16_t>());
+		condition.param1 = parse_integral<std::uint32_t>();
+		condition.param2 = parse_integral<std::uint32_t>();
+		const auto run_on = parse_integral<std::uint32_t>();
+		if (static_cast<std::uint32_t>(condition_run_on_t::event_data) < run_on)
+		{
+			return false;
+		}
+		condition.run_on = static_cast<condition_run_on_t>(run_on);
+		condition.reference = parse_formid();
+		condition.param3 = parse_integral<std::int32_t>();
+		condition.string1 = parse_string_parameter(field_type_t::cis1);
+		condition.string2 = parse_string_parameter(field_type_t::cis2);
+		program.conditions.emplace_back(condition);
+	}
+	// The last field was not a condition. Restore the stream to its previous position.
+	seek_offset(-section_str_id_offset);
+	return get_status() == parser_status_t::valid;
+}
+
 std::expected<parser_impl, std::string> acquire_state(josk::tes::parser* parser_ptr)
 {
 	assert(parser_ptr != nullptr);
@@ -741,24 +1583,34 @@ std::expected<parser_impl, std::string> acquire_state(josk::tes::parser* parser_
 
 /**
  * Open a plugin file. The parser must not have opened a file already.
- * @param path Path to existing regular file that should be a plugin file.
+ * @param path Path of the plugin file, used in reports.
  * @param name File name identifier used as an identifier on reports.
- * @param records Data structure holding parsed records from previous plugin files.
+ * @param priority Load order priority of the plugin.
+ * @param data Contents of the plugin file.
+ * @param records Data structure receiving the records accepted from this plugin.
+ * @param winners Formids claimed by all plugins.
+ * @param arena Memory resource for the parser state and its transient allocations.
+ * @param options Parse options.
+ * @param stats Statistics of the plugin. May be null.
  * @return Parser, or an error.
  */
 std::expected<parser_impl, std::string> open(
-		const std::filesystem::path& path, const std::string_view name, parser_impl::records& records
+		const std::filesystem::path& path, const std::string_view name, const josk::tes::priority_t priority,
+		josk::tes::plugin_data_t data, parser_impl::records& records, josk::tes::formid_winner_table& winners,
+		std::pmr::memory_resource* arena, const josk::tes::parse_options_t& options, josk::stats::plugin_stats_t* stats
 )
 {
-	auto parser_ptr = std::make_unique<josk::tes::parser>();
+	auto* parser_ptr = std::pmr::polymorphic_allocator<josk::tes::parser>{arena}.new_object<josk::tes::parser>(arena);
 	parser_ptr->name = name;
+	parser_ptr->priority = priority;
 	parser_ptr->records = &records;
-
-	constexpr auto open_flags = static_cast<std::ios_base::openmode>(
-			static_cast<unsigned int>(std::ios::binary) | static_cast<unsigned int>(std::ios::in)
-	);
-	parser_ptr->input.open(path, open_flags);
-	parser_impl parser{parser_ptr.release()};
+	parser_ptr->winners = &winners;
+	parser_ptr->options = &options;
+	parser_ptr->stats = stats;
+	parser_ptr->buffer = std::move(data.buffer);
+	parser_ptr->segments = std::move(data.segments);
+	parser_ptr->input.span(parser_ptr->buffer);
+	parser_impl parser{parser_ptr};
 	if (parser.get_status() != parser_impl::parser_status_t::valid)
 	{
 		return std::unexpected(parser.error_message("could not open file"));
@@ -788,6 +1640,10 @@ std::expected<parser_impl, std::string> parse(parser_impl impl)
 	auto next_group_result = impl.next_group();
 	while (next_group_result.has_value() && next_group_result.value() != invalid_group_data)
 	{
+		// Tracing uses top group granularity, to keep its overhead low.
+		const josk::trace::scope trace_scope{
+				"group", josk::tes::to_record_string(next_group_result->label_record_type)
+		};
 		if (auto parse_group_result = impl.parse_group(next_group_result.value()); !parse_group_result.has_value())
 		{
 			return std::unexpected(parse_group_result.error());
@@ -823,15 +1679,230 @@ std::expected<josk::tes::parser*, std::string> release(parser_impl impl)
 	return impl.release();
 }
 
+/**
+ * Reads a 32-bit field of a record or group header read directly from a file.
+ * @param header Header data.
+ * @param position Position of the field in the header.
+ * @return Field value.
+ */
+std::uint32_t header_field(const std::span<const char> header, const std::size_t position) noexcept
+{
+	std::array<char, sizeof(std::uint32_t)> value{};
+	std::ranges::copy_n(header.begin() + static_cast<std::ptrdiff_t>(position), value.size(), value.begin());
+	return std::bit_cast<std::uint32_t>(value);
+}
+
 }
 
 namespace josk::tes
 {
+
+fingerprint_t record_fingerprint(const std::uint32_t record_flags, const std::span<const char> record_data) noexcept
+{
+	return io::hash_bytes(record_data, record_flags);
+}
+
+std::expected<plugin_layout_t, std::string> scan_plugin_layout(const std::filesystem::path& path)
+{
+	std::error_code error{};
+	const auto file_size = std::filesystem::file_size(path, error);
+	std::ifstream input{path, std::ios::in | std::ios::binary};
+	if (error || !input.is_open())
+	{
+		return std::unexpected(std::format("Could not open plugin {}.", path.generic_string()));
+	}
+
+	// Record and group headers share the position of their type and size fields.
+	constexpr auto header_size = static_cast<std::size_t>(record_header_size.value_of());
+	std::array<char, header_size> header{};
+	const auto read_header = [&input, &header](const std::uint64_t offset)
+	{
+		input.seekg(static_cast<std::ifstream::off_type>(offset));
+		input.read(header.data(), header.size());
+		return input.good();
+	};
+	const auto header_type = [&header] { return std::string_view{header.data(), section_id_byte_size}; };
+	const auto header_value = [&header](const std::size_t position) { return header_field(header, position); };
+
+	plugin_layout_t layout{};
+	if (!read_header(0U) || header_type() != to_record_string(record_type_t::tes4))
+	{
+		return std::unexpected(std::format("Invalid TES4 file {}.", path.generic_string()));
+	}
+	layout.header_size = header_size + header_value(section_id_byte_size);
+
+	for (auto offset = layout.header_size; offset < file_size;)
+	{
+		if (!read_header(offset) || header_type() != to_record_string(record_type_t::grup))
+		{
+			return std::unexpected(std::format("Missing top group at 0x{:x} of {}.", offset, path.generic_string()));
+		}
+		const std::uint64_t group_size = header_value(section_id_byte_size);
+		if (group_size < header_size || offset + group_size > file_size)
+		{
+			return std::unexpected(std::format("Invalid top group size at 0x{:x} of {}.", offset, path.generic_string()));
+		}
+		const auto label = std::string_view{header.data() + (2Z * section_id_byte_size), section_id_byte_size};
+		layout.groups.emplace_back(to_record_type(label), offset, group_size);
+		offset += group_size;
+	}
+
+	return layout;
+}
+
+static_assert(std::input_iterator<record_reader::iterator>);
+static_assert(std::sentinel_for<std::default_sentinel_t, record_reader::iterator>);
+
+record_reader::record_reader(
+		std::ifstream file, std::string path, const std::uint64_t file_size, const record_type_set_t record_types
+)
+	: _file{std::move(file)}
+	, _path{std::move(path)}
+	, _file_size{file_size}
+	, _record_types{record_types}
+{
+}
+
+std::expected<record_reader, std::string> record_reader::open(
+		const std::filesystem::path& path, const record_type_set_t record_types
+)
+{
+	std::error_code error{};
+	const auto file_size = std::filesystem::file_size(path, error);
+	std::ifstream input{path, std::ios::in | std::ios::binary};
+	if (error || !input.is_open())
+	{
+		return std::unexpected(std::format("Could not open plugin {}.", path.generic_string()));
+	}
+
+	std::array<char, static_cast<std::size_t>(record_header_size.value_of())> header{};
+	input.read(header.data(), header.size());
+	if (!input.good() || std::string_view{header.data(), section_id_byte_size} != to_record_string(record_type_t::tes4))
+	{
+		return std::unexpected(std::format("Invalid TES4 file {}.", path.generic_string()));
+	}
+
+	record_reader reader{std::move(input), path.generic_string(), file_size, record_types};
+	reader._offset = header.size() + header_field(header, section_id_byte_size);
+	return reader;
+}
+
+bool record_reader::fail(std::string error)
+{
+	_error = std::move(error);
+	_current = {};
+	_done = true;
+	return false;
+}
+
+bool record_reader::next()
+{
+	_started = true;
+	// Record and group headers share the position of their type and size fields.
+	constexpr auto header_size = static_cast<std::size_t>(record_header_size.value_of());
+	std::array<char, header_size> header{};
+	const auto header_value = [&header](const std::size_t position) { return header_field(header, position); };
+
+	while (!_done && _offset < _file_size)
+	{
+		while (!_groups.empty() && _offset >= _groups.back().end)
+		{
+			_groups.pop_back();
+		}
+		_file.seekg(static_cast<std::ifstream::off_type>(_offset));
+		if (!_file.read(header.data(), header.size()))
+		{
+			return fail(std::format("Could not read the section header at 0x{:x} of {}.", _offset, _path));
+		}
+		const auto section_type = to_record_type(std::string_view{header.data(), section_id_byte_size});
+		const std::uint64_t section_size = header_value(section_id_byte_size);
+
+		if (section_type == record_type_t::grup)
+		{
+			if (section_size < header_size || _offset + section_size > _file_size)
+			{
+				return fail(std::format("Invalid group size at 0x{:x} of {}.", _offset, _path));
+			}
+			// The label of other groups is a formid or a grid position instead of a record type.
+			const auto group_type = std::bit_cast<group_type_t>(header_value(3Z * section_id_byte_size));
+			const std::string_view label{header.data() + (2Z * section_id_byte_size), section_id_byte_size};
+			const auto label_type = group_type == group_type_t::top ? to_record_type(label) : record_type_t::none;
+			if (!(group_record_types(group_type, label_type) & _record_types).any())
+			{
+				_offset += section_size;
+				continue;
+			}
+			auto group = _groups.empty() ? open_group_t{} : _groups.back();
+			group.end = _offset + section_size;
+			const formid_t owner_id = header_value(2Z * section_id_byte_size);
+			switch (group_type)
+			{
+				case group_type_t::world_children:
+					group.world_id = owner_id;
+					break;
+				case group_type_t::interior_cell_block:
+					group.world_id = invalid_formid;
+					break;
+				case group_type_t::cell_children:
+				case group_type_t::cell_persistent_children:
+				case group_type_t::cell_temporary_children:
+					group.cell_id = owner_id;
+					break;
+				case group_type_t::topic_children:
+					group.topic_id = owner_id;
+					break;
+				default:
+					break;
+			}
+			_groups.emplace_back(group);
+			_offset += header_size;
+			continue;
+		}
+
+		const auto data_offset = _offset + header_size;
+		if (data_offset + section_size > _file_size)
+		{
+			return fail(std::format("Record data exceeds the end of the file at 0x{:x} of {}.", _offset, _path));
+		}
+		_offset = data_offset + section_size;
+		// Records unknown to josk have no position in the record type set.
+		if (section_type == record_type_t::none || !_record_types.test(static_cast<std::size_t>(section_type)))
+		{
+			continue;
+		}
+
+		_data.resize(static_cast<std::size_t>(section_size));
+		if (!_file.read(_data.data(), static_cast<std::streamsize>(_data.size())))
+		{
+			return fail(std::format("Could not read the record data at 0x{:x} of {}.", data_offset, _path));
+		}
+		const auto group = _groups.empty() ? open_group_t{} : _groups.back();
+		_current = {
+				.record_type = section_type,
+				.record_id = header_value(3Z * section_id_byte_size),
+				.flags = header_value(2Z * section_id_byte_size),
+				.world_id = group.world_id,
+				.cell_id = group.cell_id,
+				.topic_id = group.topic_id,
+				.offset = data_offset,
+				.data = _data,
+		};
+		return true;
+	}
+
+	_current = {};
+	_done = true;
+	return false;
+}
+
 std::expected<parser*, std::string> open_plugin(
-		const std::filesystem::path& path, const std::string_view filename, parsed_records_t& parsed_records
+		const std::filesystem::path& path, const std::string_view filename, const priority_t priority, plugin_data_t data,
+		parsed_records_t& parsed_records, formid_winner_table& winners, std::pmr::memory_resource* arena,
+		const parse_options_t& options, stats::plugin_stats_t* stats
 )
 {
-	return open(path, filename, parsed_records).and_then(release);
+	return open(path, filename, priority, std::move(data), parsed_records, winners, arena, options, stats)
+			.and_then(release);
 }
 
 std::expected<parser*, std::string> parse_plugin(parser* parser_ptr)
@@ -844,4 +1915,46 @@ std::expected<void, std::string> close_plugin(parser* parser_ptr)
 	return acquire_state(parser_ptr).and_then(close);
 }
 
+std::expected<bool, std::string> decode_record(
+		const record_handle_t& handle, const std::string_view filename, io::buffer_t data, parsed_records_t& parsed_records,
+		std::pmr::memory_resource* arena
+)
+{
+	const auto parse_func = parser_impl::get_record_parse_func(handle.record_type);
+	if (parse_func == nullptr)
+	{
+		return std::unexpected(
+				std::format("Records of type {} cannot be decoded.", josk::tes::to_record_string(handle.record_type))
+		);
+	}
+	if ((handle.flags & josk::tes::compressed_record_flag) != 0U)
+	{
+		io::buffer_t decompressed_data;
+		if (const auto decompress_result = decompress_record_data(data, decompressed_data); !decompress_result.has_value())
+		{
+			return std::unexpected(
+					std::format(
+							"Could not decompress record 0x{:x} of {}: {}.", handle.record_id, filename, decompress_result.error()
+					)
+			);
+		}
+		data = std::move(decompressed_data);
+	}
+
+	// Positions of this parser are relative to the start of the record data.
+	auto* parser_ptr = std::pmr::polymorphic_allocator<parser>{arena}.new_object<parser>(arena);
+	parser_ptr->name = filename;
+	parser_ptr->priority = handle.priority;
+	parser_ptr->records = &parsed_records;
+	parser_ptr->world_id = handle.world_id;
+	parser_ptr->cell_id = handle.cell_id;
+	parser_ptr->topic_id = handle.topic_id;
+	parser_ptr->buffer = std::move(data);
+	parser_ptr->input.span(parser_ptr->buffer);
+	parser_impl impl{parser_ptr};
+	impl.append_record_to_log("record data start", handle.record_type);
+	const auto record_data_end = pos_t{static_cast<std::int64_t>(parser_ptr->buffer.size())};
+	return std::invoke(parse_func, impl, handle.record_id, record_data_end);
+}
+
 }
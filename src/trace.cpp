@@ -0,0 +1,138 @@
+#include <josk/json.hpp>
+#include <josk/trace.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+using steady_clock_t = std::chrono::steady_clock;
+
+struct event_t final
+{
+	/** Events of the same category share a string literal. */
+	std::string_view category;
+	/** Empty for end events. */
+	std::string name;
+	steady_clock_t::time_point time;
+	bool is_begin;
+};
+
+/** Events recorded by a single thread. Only that thread writes into it, so no synchronization is required. */
+struct thread_buffer_t final
+{
+	std::uint32_t thread_id{};
+	std::vector<event_t> events;
+};
+
+struct registry_t final
+{
+	std::atomic<bool> active{};
+	steady_clock_t::time_point start_time;
+	/** Buffers are only added, and they are kept alive after their thread finishes. */
+	std::mutex mutex;
+	std::vector<std::unique_ptr<thread_buffer_t>> buffers;
+};
+
+registry_t& registry() noexcept
+{
+	static registry_t instance{};
+	return instance;
+}
+
+/** Buffer of the current thread. Registration is the only operation taking a lock, and it happens once per thread. */
+thread_buffer_t& thread_buffer()
+{
+	thread_local thread_buffer_t* buffer = nullptr;
+	if (buffer == nullptr)
+	{
+		auto& [active, start_time, mutex, buffers] = registry();
+		const std::scoped_lock lock{mutex};
+		auto& created = buffers.emplace_back(std::make_unique<thread_buffer_t>());
+		created->thread_id = static_cast<std::uint32_t>(buffers.size());
+		buffer = created.get();
+	}
+	return *buffer;
+}
+
+}
+
+namespace josk::trace
+{
+
+void start()
+{
+	auto& state = registry();
+	state.start_time = steady_clock_t::now();
+	state.active.store(enabled, std::memory_order_release);
+}
+
+bool active() noexcept
+{
+	return registry().active.load(std::memory_order_relaxed);
+}
+
+void begin(const std::string_view category, const std::string_view name)
+{
+	thread_buffer().events.emplace_back(category, std::string{name}, steady_clock_t::now(), true);
+}
+
+void end()
+{
+	thread_buffer().events.emplace_back(std::string_view{}, std::string{}, steady_clock_t::now(), false);
+}
+
+std::expected<void, std::string> write(const std::filesystem::path& path)
+{
+	auto& state = registry();
+	state.active.store(false, std::memory_order_release);
+	const std::scoped_lock lock{state.mutex};
+
+	std::string output{"{\"traceEvents\":["};
+	auto out = std::back_inserter(output);
+	bool first{true};
+	for (const auto& buffer : state.buffers)
+	{
+		for (const auto& [category, name, time, is_begin] : buffer->events)
+		{
+			const auto timestamp = std::chrono::duration<double, std::micro>(time - state.start_time).count();
+			output.append(first ? "\n{" : ",\n{");
+			if (is_begin)
+			{
+				output.append("\"name\":");
+				json::append_string(output, name);
+				output.append(",\"cat\":");
+				json::append_string(output, category);
+				output.append(",");
+			}
+			std::format_to(
+					out, "\"ph\":\"{}\",\"ts\":{:.3f},\"pid\":1,\"tid\":{}}}", is_begin ? 'B' : 'E', timestamp, buffer->thread_id
+			);
+			first = false;
+		}
+	}
+	output.append("\n]}\n");
+
+	std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+	file.write(output.data(), static_cast<std::streamsize>(output.size()));
+	if (!file.good())
+	{
+		return std::unexpected(std::format("Could not write trace file {}.", path.generic_string()));
+	}
+	return {};
+}
+
+}
@@ -0,0 +1,63 @@
+#include "synthetic_plugin.hpp"
+
+#include <CLI/App.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <print>
+
+int main(const int argc, char* argv[])
+{
+	CLI::App app{};
+	app.name("josk_generate");
+	app.description("Generate a synthetic Mod Organizer 2 modlist for testing and benchmarking josk.");
+
+	std::filesystem::path output_path;
+	josk::synthetic::modlist_spec_t spec{};
+	auto& plugin = spec.plugin;
+	app.add_option("-o,--output", output_path, "Folder receiving the modlist.")->required(true);
+	app.add_option("--mods", spec.mod_count, "Number of mods, each one with a single plugin.")->capture_default_str();
+	app.add_option("--assets", spec.assets_per_mod, "Number of asset files of each mod.")->capture_default_str();
+	app.add_option("--avif", plugin.avif_count, "Number of AVIF records of each plugin.")->capture_default_str();
+	app.add_option("--perks", plugin.perks_per_avif, "Number of PERK records of each AVIF.")->capture_default_str();
+	app.add_option("--ignored-groups", plugin.ignored_group_count, "Number of ignored groups of each plugin.")
+			->capture_default_str();
+	app.add_option("--ignored-records", plugin.ignored_records_per_group, "Number of records of each ignored group.")
+			->capture_default_str();
+	app.add_option(
+				 "--compressed-records", plugin.compressed_records_per_group,
+				 "Number of compressed records of each ignored group."
+	)
+			->capture_default_str();
+	app.add_option(
+				 "--override-trees", plugin.override_tree_count,
+				 "Number of skill trees of each plugin which override the ones of Skyrim.esm."
+	)
+			->capture_default_str();
+	CLI11_PARSE(app, argc, argv);
+
+	if (plugin.override_tree_count > plugin.avif_count)
+	{
+		std::println(stderr, "--override-trees cannot be larger than --avif.");
+		return EXIT_FAILURE;
+	}
+	if (plugin.compressed_records_per_group > plugin.ignored_records_per_group)
+	{
+		std::println(stderr, "--compressed-records cannot be larger than --ignored-records.");
+		return EXIT_FAILURE;
+	}
+
+	const auto paths = josk::synthetic::write_modlist(output_path, spec);
+	if (!paths.has_value())
+	{
+		std::println(stderr, "{}", paths.error());
+		return EXIT_FAILURE;
+	}
+
+	std::println(
+			"josk --profile {} --data {} --mods {} --output <output>", paths->profile_path.string(),
+			paths->data_path.string(), paths->mods_path.string()
+	);
+	return EXIT_SUCCESS;
+}
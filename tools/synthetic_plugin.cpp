@@ -0,0 +1,500 @@
+#include "synthetic_plugin.hpp"
+
+#include <josk/tes_format.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+static_assert(std::endian::native == std::endian::little, "TES files are little-endian.");
+
+using josk::tes::formid_t;
+
+/** Record types used to fill ignored groups. */
+constexpr std::array<std::string_view, 8Z> ignored_record_types{
+		"STAT", "MISC", "ARMO", "WEAP", "BOOK", "FLOR", "LIGH", "ACTI",
+};
+
+/** Record flag indicating that its data is compressed with zlib. */
+constexpr std::uint32_t compressed_record_flag = 0x00040000U;
+
+/** Layout of a CTDA field. */
+struct condition_data final
+{
+	std::uint8_t op_and_flags{};
+	std::array<std::uint8_t, 3Z> unused{};
+	float value{};
+	std::uint16_t function{};
+	std::uint16_t padding{};
+	std::uint32_t param1{};
+	std::uint32_t param2{};
+	/** Subject. */
+	std::uint32_t run_on{};
+	formid_t reference{};
+	std::int32_t param3{-1};
+};
+
+static_assert(sizeof(condition_data) == 32Z);
+
+/** First actor value of a skill. Skills go from one-handed to enchanting. */
+constexpr std::uint32_t first_skill_actor_value = 6U;
+constexpr std::uint32_t skill_count = 18U;
+
+/** Adler-32 checksum, as required by the zlib format. */
+std::uint32_t adler32(const std::span<const char> data) noexcept
+{
+	constexpr std::uint32_t modulus = 65521U;
+	std::uint32_t low{1U};
+	std::uint32_t high{};
+	for (const char character : data)
+	{
+		low = (low + static_cast<unsigned char>(character)) % modulus;
+		high = (high + low) % modulus;
+	}
+	return (high << 16U) | low;
+}
+
+/**
+ * Wraps data in a zlib stream made of stored deflate blocks. The result is valid zlib data which any inflate
+ * implementation accepts, without depending on a compression library.
+ * @param data Data to wrap.
+ * @return zlib stream.
+ */
+std::vector<char> to_zlib_stream(const std::span<const char> data)
+{
+	constexpr std::size_t max_stored_block_size = 0xFFFFZ;
+	std::vector<char> stream{'\x78', '\x01'};
+	std::size_t offset{};
+	do
+	{
+		const auto block_size = std::min(max_stored_block_size, data.size() - offset);
+		const bool is_final = offset + block_size == data.size();
+		const auto length = static_cast<std::uint16_t>(block_size);
+		const auto inverse_length = static_cast<std::uint16_t>(~length);
+		stream.push_back(is_final ? '\x01' : '\x00');
+		for (const auto value : {length, inverse_length})
+		{
+			stream.push_back(static_cast<char>(value & 0xFFU));
+			stream.push_back(static_cast<char>(value >> 8U));
+		}
+		stream.insert(stream.end(), data.begin() + static_cast<std::ptrdiff_t>(offset),
+									data.begin() + static_cast<std::ptrdiff_t>(offset + block_size));
+		offset += block_size;
+	} while (offset < data.size());
+
+	// The checksum is stored in big-endian order.
+	const auto checksum = adler32(data);
+	for (const auto shift : {24U, 16U, 8U, 0U})
+	{
+		stream.push_back(static_cast<char>((checksum >> shift) & 0xFFU));
+	}
+	return stream;
+}
+
+/** Appends TES file sections into a buffer. */
+class plugin_writer final
+{
+	std::vector<char> _data;
+
+	/** Bytes of a record header after its size field. */
+	static constexpr std::size_t remaining_record_header_size =
+			sizeof(std::uint32_t) + sizeof(formid_t) + sizeof(std::uint64_t);
+
+public:
+	template <typename Value>
+	void write(const Value value)
+	{
+		const auto bytes = std::bit_cast<std::array<char, sizeof(Value)>>(value);
+		_data.insert(_data.end(), bytes.cbegin(), bytes.cend());
+	}
+
+	void write_id(const std::string_view id)
+	{
+		_data.insert(_data.end(), id.cbegin(), id.cend());
+	}
+
+	/** Starts a record or group section and returns the position of its size, to be patched when it ends. */
+	std::size_t begin_section(const std::string_view type)
+	{
+		write_id(type);
+		const auto size_position = _data.size();
+		write(std::uint32_t{});
+		return size_position;
+	}
+
+	/**
+	 * Finishes a section by patching its size.
+	 * @param size_position Position returned by begin_section.
+	 * @param header_size Bytes of the header after the size field.
+	 * @param include_header Group sizes include their whole header, while record sizes only count their data.
+	 */
+	void end_section(const std::size_t size_position, const std::size_t header_size, const bool include_header)
+	{
+		const auto data_begin = size_position + sizeof(std::uint32_t) + header_size;
+		auto size = _data.size() - data_begin;
+		if (include_header)
+		{
+			size += josk::tes::section_id_byte_size + sizeof(std::uint32_t) + header_size;
+		}
+		const auto bytes = std::bit_cast<std::array<char, sizeof(std::uint32_t)>>(static_cast<std::uint32_t>(size));
+		std::ranges::copy(bytes, _data.begin() + static_cast<std::ptrdiff_t>(size_position));
+	}
+
+	/** Starts a record. Must be finished with end_record. */
+	std::size_t begin_record(const std::string_view type, const formid_t formid, const std::uint32_t flags = 0U)
+	{
+		const auto size_position = begin_section(type);
+		write(flags);
+		write(formid);
+		write(std::uint64_t{}); // Timestamp, version control, version and unknown.
+		return size_position;
+	}
+
+	void end_record(const std::size_t size_position)
+	{
+		end_section(size_position, remaining_record_header_size, false);
+	}
+
+	/** Finishes a record started with compressed_record_flag, replacing its data with the compressed version. */
+	void end_compressed_record(const std::size_t size_position)
+	{
+		const auto data_begin = _data.begin() + static_cast<std::ptrdiff_t>(
+																								size_position + sizeof(std::uint32_t) + remaining_record_header_size
+																						);
+		const std::vector<char> uncompressed(data_begin, _data.end());
+		_data.erase(data_begin, _data.end());
+		write(static_cast<std::uint32_t>(uncompressed.size()));
+		const auto stream = to_zlib_stream(uncompressed);
+		_data.insert(_data.end(), stream.cbegin(), stream.cend());
+		end_record(size_position);
+	}
+
+	/** Starts a top group. Must be finished with end_group. */
+	std::size_t begin_group(const std::string_view label)
+	{
+		const auto size_position = begin_section("GRUP");
+		write_id(label);
+		write(std::int32_t{}); // Top group.
+		write(std::uint64_t{}); // Timestamp, version control and unknown.
+		return size_position;
+	}
+
+	void end_group(const std::size_t size_position)
+	{
+		constexpr std::size_t remaining_header_size = josk::tes::section_id_byte_size + sizeof(std::int32_t) +
+																									sizeof(std::uint64_t);
+		end_section(size_position, remaining_header_size, true);
+	}
+
+	template <typename Value>
+	void write_field(const std::string_view type, const Value value)
+	{
+		write_id(type);
+		write(static_cast<std::uint16_t>(sizeof(Value)));
+		write(value);
+	}
+
+	/** Writes a field containing a null-terminated string. */
+	void write_string_field(const std::string_view type, const std::string_view value)
+	{
+		write_id(type);
+		write(static_cast<std::uint16_t>(value.size() + 1Z));
+		write_id(value);
+		_data.push_back('\0');
+	}
+
+	[[nodiscard]] std::vector<char> release() noexcept
+	{
+		return std::move(_data);
+	}
+};
+
+void write_header(plugin_writer& writer, const std::uint64_t records, const formid_t next_formid)
+{
+	const auto size_position = writer.begin_record("TES4", formid_t{});
+	writer.write_id("HEDR");
+	writer.write(std::uint16_t{12U});
+	writer.write(1.71F); // Version.
+	writer.write(static_cast<std::uint32_t>(records));
+	writer.write(next_formid);
+	writer.write_string_field("CNAM", "josk");
+	writer.end_record(size_position);
+}
+
+/** First formid of a skill tree. Each tree has an AVIF record followed by its perks. */
+formid_t tree_first_formid(const josk::synthetic::plugin_spec_t& spec, const std::uint32_t avif_index) noexcept
+{
+	return avif_index < spec.override_tree_count ? spec.override_first_formid : spec.first_formid;
+}
+
+void write_avif(plugin_writer& writer, const josk::synthetic::plugin_spec_t& spec, const std::uint32_t avif_index)
+{
+	const auto first_formid = tree_first_formid(spec, avif_index);
+	const formid_t avif_id = first_formid + avif_index;
+	const formid_t first_perk_id = first_formid + spec.avif_count + (avif_index * spec.perks_per_avif);
+	const auto size_position = writer.begin_record("AVIF", avif_id);
+	writer.write_string_field("EDID", std::format("SyntheticSkill{:08X}", avif_id));
+	writer.write_string_field("FULL", std::format("Synthetic skill {}", avif_index));
+	writer.write_string_field("DESC", "Skill tree generated for testing and benchmarking purposes.");
+	writer.write_field("CNAM", std::uint32_t{avif_index % 4U});
+	for (std::uint32_t perk_index{}; perk_index < spec.perks_per_avif; ++perk_index)
+	{
+		writer.write_field("PNAM", first_perk_id + perk_index);
+		writer.write_field("FNAM", std::uint32_t{1U});
+		writer.write_field("XNAM", perk_index % 5U);
+		writer.write_field("YNAM", perk_index / 5U);
+		writer.write_field("HNAM", static_cast<float>(perk_index % 5U) * 0.25F);
+		writer.write_field("VNAM", static_cast<float>(perk_index / 5U) * 0.5F);
+		writer.write_field("SNAM", avif_id);
+		writer.write_field("INAM", perk_index);
+	}
+	writer.end_record(size_position);
+}
+
+/**
+ * Writes a perk requiring a skill level and, for perks with previous ranks, the previous rank.
+ * @param writer Plugin writer.
+ * @param perk_id Formid of the perk.
+ * @param skill_actor_value Actor value of the skill of the tree.
+ * @param skill_level Skill level required by the perk.
+ * @param previous_rank_id Formid of the previous rank, or invalid_formid.
+ * @param has_next_rank Whether the perk has a next rank, placed right after it.
+ */
+void write_perk(
+		plugin_writer& writer, const formid_t perk_id, const std::uint32_t skill_actor_value, const float skill_level,
+		const formid_t previous_rank_id, const bool has_next_rank
+)
+{
+	// The comparison operator is stored in the upper three bits.
+	constexpr auto greater_equal = static_cast<std::uint8_t>(
+			static_cast<std::uint8_t>(josk::tes::compare_op_t::greater_equal) << 5U
+	);
+	constexpr auto equal = static_cast<std::uint8_t>(static_cast<std::uint8_t>(josk::tes::compare_op_t::equal) << 5U);
+
+	const auto size_position = writer.begin_record("PERK", perk_id);
+	writer.write_string_field("EDID", std::format("SyntheticPerk{:08X}", perk_id));
+	writer.write_string_field("FULL", std::format("Synthetic perk {:08X}", perk_id));
+	writer.write_string_field("DESC", "Perk generated for testing and benchmarking purposes.");
+	condition_data skill_condition{};
+	skill_condition.op_and_flags = greater_equal;
+	skill_condition.value = skill_level;
+	skill_condition.function = static_cast<std::uint16_t>(josk::tes::condition_function_t::get_base_actor_value);
+	skill_condition.param1 = skill_actor_value;
+	writer.write_field("CTDA", skill_condition);
+	if (previous_rank_id != josk::tes::invalid_formid)
+	{
+		condition_data rank_condition{};
+		rank_condition.op_and_flags = equal;
+		rank_condition.value = 1.0F;
+		rank_condition.function = static_cast<std::uint16_t>(josk::tes::condition_function_t::has_perk);
+		rank_condition.param1 = previous_rank_id;
+		writer.write_field("CTDA", rank_condition);
+	}
+	writer.write_id("DATA");
+	writer.write(std::uint16_t{5U});
+	writer.write(std::int8_t{}); // Is trait.
+	writer.write(std::int8_t{}); // Level.
+	writer.write(std::int8_t{has_next_rank ? std::int8_t{2} : std::int8_t{1}}); // Number of ranks.
+	writer.write(true); // Is playable.
+	writer.write(false); // Is hidden.
+	if (has_next_rank)
+	{
+		writer.write_field("NNAM", perk_id + 1U);
+	}
+	writer.end_record(size_position);
+}
+
+void write_ignored_record(
+		plugin_writer& writer, const std::string_view type, const formid_t formid, const bool is_compressed
+)
+{
+	const auto size_position = writer.begin_record(type, formid, is_compressed ? compressed_record_flag : 0U);
+	writer.write_string_field("EDID", std::format("Synthetic{}{:08X}", type, formid));
+	writer.write_field("DATA", std::array<std::uint32_t, 4Z>{formid, 1U, 2U, 3U});
+	if (is_compressed)
+	{
+		writer.end_compressed_record(size_position);
+	}
+	else
+	{
+		writer.end_record(size_position);
+	}
+}
+
+
+std::expected<void, std::string> write_file(const std::filesystem::path& path, const std::span<const char> data)
+{
+	std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+	file.write(data.data(), static_cast<std::streamsize>(data.size()));
+	if (!file.good())
+	{
+		return std::unexpected(std::format("Could not write {}.", path.generic_string()));
+	}
+	return {};
+}
+
+/** Asset folders of real mods, in which plugins must not be searched. */
+constexpr std::array<std::string_view, 4Z> asset_folders{"meshes", "textures", "scripts", "sound/fx"};
+
+/**
+ * Writes empty asset files in the nested folder structure used by real mods.
+ * @param mod_path Mod folder.
+ * @param mod_index Index of the mod.
+ * @param asset_count Number of asset files to write.
+ * @return Nothing, or an error.
+ */
+std::expected<void, std::string> write_assets(
+		const std::filesystem::path& mod_path, const std::uint32_t mod_index, const std::uint32_t asset_count
+)
+{
+	for (std::uint32_t asset_index{}; asset_index < asset_count; ++asset_index)
+	{
+		const auto folder = mod_path / asset_folders[asset_index % asset_folders.size()] / "synthetic" /
+												std::format("mod_{:04}", mod_index);
+		std::error_code error{};
+		if (std::filesystem::create_directories(folder, error); error)
+		{
+			return std::unexpected(std::format("Could not create {}: {}", folder.generic_string(), error.message()));
+		}
+		if (auto result = write_file(folder / std::format("asset_{:04}.bin", asset_index), {}); !result.has_value())
+		{
+			return result;
+		}
+	}
+	return {};
+}
+
+}
+
+namespace josk::synthetic
+{
+
+std::uint64_t record_count(const plugin_spec_t& spec) noexcept
+{
+	return std::uint64_t{spec.avif_count} + (std::uint64_t{spec.avif_count} * spec.perks_per_avif) +
+				 (std::uint64_t{spec.ignored_group_count} * spec.ignored_records_per_group);
+}
+
+std::vector<char> write_plugin(const plugin_spec_t& spec)
+{
+	plugin_writer writer{};
+	const auto records = record_count(spec);
+	write_header(writer, records, static_cast<formid_t>(spec.first_formid + records));
+
+	const auto avif_group = writer.begin_group("AVIF");
+	for (std::uint32_t avif_index{}; avif_index < spec.avif_count; ++avif_index)
+	{
+		write_avif(writer, spec, avif_index);
+	}
+	writer.end_group(avif_group);
+
+	const auto perk_group = writer.begin_group("PERK");
+	for (std::uint32_t avif_index{}; avif_index < spec.avif_count; ++avif_index)
+	{
+		const formid_t first_perk_id =
+				tree_first_formid(spec, avif_index) + spec.avif_count + (avif_index * spec.perks_per_avif);
+		for (std::uint32_t perk_index{}; perk_index < spec.perks_per_avif; ++perk_index)
+		{
+			// Perks of each tree come in pairs of ranks. Each pair requires a higher skill level.
+			const bool is_first_rank = perk_index % 2U == 0U;
+			const bool has_next_rank = is_first_rank && perk_index + 1U < spec.perks_per_avif;
+			const auto perk_id = first_perk_id + perk_index;
+			write_perk(
+					writer, perk_id, first_skill_actor_value + (avif_index % skill_count),
+					static_cast<float>((perk_index / 2U) * 10U), is_first_rank ? josk::tes::invalid_formid : perk_id - 1U,
+					has_next_rank
+			);
+		}
+	}
+	writer.end_group(perk_group);
+
+	formid_t next_formid = spec.first_formid + spec.avif_count + (spec.avif_count * spec.perks_per_avif);
+	for (std::uint32_t group_index{}; group_index < spec.ignored_group_count; ++group_index)
+	{
+		const auto type = ignored_record_types[group_index % ignored_record_types.size()];
+		const auto ignored_group = writer.begin_group(type);
+		for (std::uint32_t record_index{}; record_index < spec.ignored_records_per_group; ++record_index)
+		{
+			write_ignored_record(writer, type, next_formid++, record_index < spec.compressed_records_per_group);
+		}
+		writer.end_group(ignored_group);
+	}
+
+	return writer.release();
+}
+
+std::expected<modlist_paths_t, std::string> write_modlist(const std::filesystem::path& root, const modlist_spec_t& spec)
+{
+	namespace fs = std::filesystem;
+	modlist_paths_t paths{
+			.profile_path = root / "profile",
+			.data_path = root / "data",
+			.mods_path = root / "mods",
+	};
+	std::error_code error{};
+	for (const auto& path : {paths.profile_path, paths.data_path, paths.mods_path})
+	{
+		if (fs::create_directories(path, error); error)
+		{
+			return std::unexpected(std::format("Could not create {}: {}", path.generic_string(), error.message()));
+		}
+	}
+
+	const auto records_per_plugin = static_cast<formid_t>(record_count(spec.plugin));
+	std::string load_order{"Skyrim.esm\n"};
+	auto master_spec = spec.plugin;
+	master_spec.override_tree_count = 0U;
+	if (auto result = write_file(paths.data_path / "Skyrim.esm", write_plugin(master_spec)); !result.has_value())
+	{
+		return std::unexpected(std::move(result.error()));
+	}
+
+	for (std::uint32_t mod_index{1U}; mod_index <= spec.mod_count; ++mod_index)
+	{
+		const auto filename = std::format("synthetic_{:04}.esp", mod_index);
+		const auto mod_path = paths.mods_path / std::format("synthetic_mod_{:04}", mod_index);
+		if (fs::create_directories(mod_path, error); error)
+		{
+			return std::unexpected(std::format("Could not create {}: {}", mod_path.generic_string(), error.message()));
+		}
+
+		auto plugin_spec = spec.plugin;
+		plugin_spec.override_first_formid = spec.plugin.first_formid;
+		plugin_spec.first_formid += mod_index * records_per_plugin;
+		if (auto result = write_file(mod_path / filename, write_plugin(plugin_spec)); !result.has_value())
+		{
+			return std::unexpected(std::move(result.error()));
+		}
+		if (auto result = write_assets(mod_path, mod_index, spec.assets_per_mod); !result.has_value())
+		{
+			return std::unexpected(std::move(result.error()));
+		}
+		load_order.append(filename);
+		load_order.push_back('\n');
+	}
+
+	if (auto result = write_file(paths.profile_path / "loadorder.txt", {load_order.cbegin(), load_order.cend()});
+			!result.has_value())
+	{
+		return std::unexpected(std::move(result.error()));
+	}
+	return paths;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <josk/tes_format.hpp>
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace josk::synthetic
+{
+
+/** Contents of a synthetic plugin. Records are generated deterministically from these values. */
+struct plugin_spec_t final
+{
+	/** First formid used by the plugin. Following records use consecutive formids. */
+	tes::formid_t first_formid{0x00000800U};
+	/** Number of AVIF records. Each one references its own perks. */
+	std::uint32_t avif_count{18U};
+	/** Number of PERK records referenced by each AVIF record. */
+	std::uint32_t perks_per_avif{20U};
+	/** Number of top groups containing records of types ignored by josk. */
+	std::uint32_t ignored_group_count{8U};
+	/** Number of records in each ignored group. */
+	std::uint32_t ignored_records_per_group{512U};
+	/** Number of records of each ignored group stored with zlib compression. */
+	std::uint32_t compressed_records_per_group{0U};
+	/** Number of skill trees (an AVIF and its perks) overriding records of another plugin instead of adding new ones. */
+	std::uint32_t override_tree_count{0U};
+	/** First formid of the plugin whose skill trees are overridden. */
+	tes::formid_t override_first_formid{0x00000800U};
+};
+
+/**
+ * Generates the contents of a plugin file.
+ * @param spec Plugin contents.
+ * @return Plugin file data.
+ */
+[[nodiscard]] std::vector<char> write_plugin(const plugin_spec_t& spec);
+
+/**
+ * Number of records of a plugin, excluding its TES4 header.
+ * @param spec Plugin contents.
+ * @return Record count.
+ */
+[[nodiscard]] std::uint64_t record_count(const plugin_spec_t& spec) noexcept;
+
+/** Mod Organizer 2 style modlist made of synthetic plugins. */
+struct modlist_spec_t final
+{
+	/** Number of mods, each one containing a single plugin. */
+	std::uint32_t mod_count{64U};
+	/**
+	 * Contents of each plugin. Formids are shifted so that each plugin adds its own records. Skill trees included in
+	 * override_tree_count override the ones of Skyrim.esm, which uses the same contents without overrides.
+	 */
+	plugin_spec_t plugin;
+	/** Number of asset files added to each mod, in nested folders like the ones of real mods. */
+	std::uint32_t assets_per_mod{8U};
+};
+
+/** Paths of a generated modlist, matching the josk command line arguments. */
+struct modlist_paths_t final
+{
+	std::filesystem::path profile_path;
+	std::filesystem::path data_path;
+	std::filesystem::path mods_path;
+};
+
+/**
+ * Writes a modlist: a profile folder with its loadorder.txt, a data folder with Skyrim.esm, and a mods folder. Existing
+ * files are overwritten.
+ * @param root Folder receiving the modlist. It is created if it does not exist.
+ * @param spec Modlist contents.
+ * @return Modlist paths, or an error.
+ */
+std::expected<modlist_paths_t, std::string> write_modlist(
+		const std::filesystem::path& root, const modlist_spec_t& spec
+);
+
+}